@@ -0,0 +1,56 @@
+
+#include "attack_map.hpp"
+
+AttackMap::AttackMap(const Board &board) noexcept {
+  const bitboard_t occupied = board.occupied();
+  const bitboard_t pawn_attacks[2] = {
+      pawn_attacks_bb(board.pieces(WHITE_PAWN), WHITE),
+      pawn_attacks_bb(board.pieces(BLACK_PAWN), BLACK),
+  };
+  const bitboard_t king_zones[2] = {
+      king_zone(lsb(board.pieces(WHITE_KING))),
+      king_zone(lsb(board.pieces(BLACK_KING))),
+  };
+  by_piece[WHITE_PAWN] = pawn_attacks[WHITE];
+  by_piece[BLACK_PAWN] = pawn_attacks[BLACK];
+
+  for (const piece_t piece :
+       {WHITE_KNIGHT, WHITE_BISHOP, WHITE_ROOK, WHITE_QUEEN, WHITE_KING,
+        BLACK_KNIGHT, BLACK_BISHOP, BLACK_ROOK, BLACK_QUEEN, BLACK_KING}) {
+    const int side = get_side(piece);
+    const bitboard_t mobility_area =
+        ~board.side_pieces(side) & ~pawn_attacks[!side];
+    bitboard_t pieces = board.pieces(piece);
+    while (pieces) {
+      const int sq64 = pop_lsb(pieces);
+      bitboard_t attacks = 0;
+      switch (to_white(piece)) {
+      case WHITE_KNIGHT:
+        attacks = knight_attacks[sq64];
+        break;
+      case WHITE_BISHOP:
+        attacks = bishop_attacks(sq64, occupied);
+        break;
+      case WHITE_ROOK:
+        attacks = rook_attacks(sq64, occupied);
+        break;
+      case WHITE_QUEEN:
+        attacks = queen_attacks(sq64, occupied);
+        break;
+      case WHITE_KING:
+        attacks = king_attacks[sq64];
+        break;
+      }
+      by_piece[piece] |= attacks;
+      mobility[side] +=
+          mobility_score(piece, popcount(attacks & mobility_area));
+      if (!is_king(piece) && (attacks & king_zones[!side])) {
+        king_attackers[side]++;
+        king_attack_weight[side] += king_attack_weights[piece];
+      }
+    }
+  }
+
+  for (piece_t piece = 0; piece < 16; ++piece)
+    by_side[piece < 8 ? WHITE : BLACK] |= by_piece[piece];
+}
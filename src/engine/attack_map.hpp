@@ -0,0 +1,61 @@
+
+#pragma once
+
+#include "bitboard.hpp"
+#include "board.hpp"
+#include "piece_values.hpp"
+#include "types.hpp"
+
+// The bonus for a piece with num_squares squares to move to, relative to a
+// typical number for the piece
+constexpr inline score_t mobility_score(const piece_t piece,
+                                        const int num_squares) {
+  switch (to_white(piece)) {
+  case WHITE_KNIGHT:
+    return make_score(4, 4) * (num_squares - 4);
+  case WHITE_BISHOP:
+    return make_score(5, 5) * (num_squares - 6);
+  case WHITE_ROOK:
+    return make_score(2, 4) * (num_squares - 6);
+  case WHITE_QUEEN:
+    return make_score(1, 2) * (num_squares - 12);
+  default:
+    return 0;
+  }
+}
+
+// How dangerous each piece is when it attacks the enemy king's zone. Pawns
+// and kings are not counted as attackers.
+constexpr int king_attack_weights[16] = {
+    5, 3, 0, 0, //
+    2, 2, 0, 0, // White pieces
+    5, 3, 0, 0, //
+    2, 2, 0, 0, // Black pieces
+};
+
+// The squares each side attacks, by piece, built in a single pass over the
+// board's pieces. Along the way, the pass also tallies what the evaluation
+// needs from each piece's attacks, so that it never generates them again:
+//   - mobility: the squares each piece attacks which are neither occupied by
+//     its own side nor attacked by enemy pawns
+//   - king attacks: how many pieces other than pawns and the king attack the
+//     squares around the enemy king, and a weight for how dangerous they are
+struct AttackMap {
+  bitboard_t by_piece[16] = {};
+  bitboard_t by_side[2] = {};
+
+  score_t mobility[2] = {};
+  int king_attackers[2] = {}; // Attacking the other side's king zone
+  int king_attack_weight[2] = {};
+
+  explicit AttackMap(const Board &board) noexcept;
+
+  bool attacks(const int side, const int sq64) const noexcept {
+    return by_side[side] & square_bb(sq64);
+  }
+};
+
+// The squares around the king, which its attackers aim for
+inline bitboard_t king_zone(const int king64) {
+  return king_attacks[king64] | square_bb(king64);
+}
@@ -0,0 +1,196 @@
+#include "bitboard.hpp"
+
+#include <initializer_list>
+#include <sstream>
+
+static bool bitboard_flag = 0;
+
+bitboard_t knight_attacks[64];
+bitboard_t king_attacks[64];
+bitboard_t pawn_attacks[2][64];
+bitboard_t ray_attacks[8][64];
+bitboard_t between_bb[64][64];
+bitboard_t line_bb[64][64];
+
+SliderMagic bishop_magics[64];
+SliderMagic rook_magics[64];
+bool use_pext = false;
+
+// Each square needs 2^popcount(mask) entries: these are the totals over all
+// squares
+static bitboard_t bishop_table[5248];
+static bitboard_t rook_table[102400];
+
+// Builds the attacks of a piece on sq64 which steps once along each offset,
+// using the 120-square board to detect falling off the edge
+static bitboard_t leaper_attacks(const int sq64,
+                                 std::initializer_list<int> offsets) {
+  const square_t start = get_square_120(sq64);
+  bitboard_t result = 0;
+  for (const int offset : offsets) {
+    const square_t cur_square = start + offset;
+    if (valid_square(cur_square))
+      result |= square_bb_120(cur_square);
+  }
+  return result;
+}
+
+// Builds the full (empty board) ray from sq64 along the given offset, not
+// including sq64 itself
+static bitboard_t slider_ray(const int sq64, const int offset) {
+  bitboard_t result = 0;
+  square_t cur_square = get_square_120(sq64) + offset;
+  while (valid_square(cur_square)) {
+    result |= square_bb_120(cur_square);
+    cur_square += offset;
+  }
+  return result;
+}
+
+// Computes sliding attacks by walking each ray up to its first blocker. This
+// is only used to fill the lookup tables.
+static bitboard_t ray_slider_attacks(const int sq64, const bitboard_t occ,
+                                     const Direction (&directions)[4]) {
+  bitboard_t result = 0;
+  for (const Direction dir : directions) {
+    bitboard_t attacks = ray_attacks[dir][sq64];
+    const bitboard_t blockers = attacks & occ;
+    if (blockers) {
+      // Rays pointing north or east run towards higher bit indices, so their
+      // first blocker is the least significant one
+      const bool positive = dir == NORTH || dir == NORTH_EAST ||
+                            dir == EAST || dir == NORTH_WEST;
+      attacks ^= ray_attacks[dir][positive ? lsb(blockers) : msb(blockers)];
+    }
+    result |= attacks;
+  }
+  return result;
+}
+
+static bool host_has_fast_pext() {
+#ifdef HAS_PEXT_ASM
+  __builtin_cpu_init();
+  // AMD implements PEXT in microcode before Zen 3, where it is much slower
+  // than the magic multiplication
+  return __builtin_cpu_supports("bmi2") && !__builtin_cpu_is("amdfam17h");
+#else
+  return false;
+#endif
+}
+
+// Fills in the mask, shift and attack table of every square for one kind of
+// slider, searching for magic multipliers unless we index with PEXT
+static void init_slider_magics(SliderMagic (&magics)[64], bitboard_t *table,
+                               const Direction (&directions)[4]) {
+  static bitboard_t occupancies[4096], reference[4096];
+  static int epoch[4096] = {0};
+  int cur_epoch = 0;
+
+  for (int sq64 = 0; sq64 < 64; ++sq64) {
+    // Blockers on the edge of the board never change the attacked squares, so
+    // they are left out of the mask
+    const int row = sq64 / 8, col = sq64 % 8;
+    const bitboard_t edges =
+        ((RANK_1_BB | RANK_8_BB) & ~(RANK_1_BB << (8 * row))) |
+        ((FILE_A_BB | FILE_H_BB) & ~(FILE_A_BB << col));
+    SliderMagic &entry = magics[sq64];
+    entry.mask = ray_slider_attacks(sq64, 0, directions) & ~edges;
+    entry.shift = 64 - popcount(entry.mask);
+    entry.attacks = table;
+
+    // Enumerate every subset of the mask with the Carry-Rippler trick
+    int size = 0;
+    bitboard_t occ = 0;
+    do {
+      occupancies[size] = occ;
+      reference[size] = ray_slider_attacks(sq64, occ, directions);
+      size++;
+      occ = (occ - entry.mask) & entry.mask;
+    } while (occ);
+    table += size;
+
+    if (use_pext) {
+#ifdef HAS_PEXT_ASM
+      for (int i = 0; i < size; ++i)
+        entry.attacks[pext(occupancies[i], entry.mask)] = reference[i];
+#endif
+      continue;
+    }
+
+    // Try sparse random multipliers until one maps every occupancy to a slot
+    // without destructive collisions. The per-rank seeds are known to find
+    // magics quickly, so that startup stays fast and deterministic.
+    constexpr uint64_t seeds[8] = {728,   10316, 55013, 32803,
+                                   12281, 15100, 16645, 255};
+    uint64_t state = seeds[row];
+    const auto random = [&state]() {
+      // xorshift64*
+      state ^= state >> 12, state ^= state << 25, state ^= state >> 27;
+      return state * 2685821657736338717ULL;
+    };
+    for (int i = 0; i < size;) {
+      entry.magic = random() & random() & random();
+      if (popcount((entry.mask * entry.magic) >> 56) < 6)
+        continue;
+      cur_epoch++;
+      for (i = 0; i < size; ++i) {
+        const unsigned idx = entry.index(occupancies[i]);
+        if (epoch[idx] < cur_epoch) {
+          epoch[idx] = cur_epoch;
+          entry.attacks[idx] = reference[i];
+        } else if (entry.attacks[idx] != reference[i]) {
+          break;
+        }
+      }
+    }
+  }
+}
+
+void init_bitboards() noexcept {
+  if (bitboard_flag)
+    return;
+  // Offsets on the 120-square board, in the same order as Direction
+  constexpr int direction_offsets[8] = {10, 11, 1, -9, -10, -11, -1, 9};
+  for (int sq64 = 0; sq64 < 64; ++sq64) {
+    knight_attacks[sq64] =
+        leaper_attacks(sq64, {-21, -19, -12, -8, 8, 12, 19, 21});
+    king_attacks[sq64] =
+        leaper_attacks(sq64, {-11, -10, -9, -1, 1, 9, 10, 11});
+    pawn_attacks[0][sq64] = leaper_attacks(sq64, {9, 11});   // White
+    pawn_attacks[1][sq64] = leaper_attacks(sq64, {-9, -11}); // Black
+    for (int dir = 0; dir < 8; ++dir)
+      ray_attacks[dir][sq64] = slider_ray(sq64, direction_offsets[dir]);
+  }
+
+  for (int from = 0; from < 64; ++from) {
+    for (int dir = 0; dir < 8; ++dir) {
+      // Directions are listed clockwise, so the opposite is 4 steps away
+      const int opposite = (dir + 4) % 8;
+      const bitboard_t line = ray_attacks[dir][from] |
+                              ray_attacks[opposite][from] | square_bb(from);
+      bitboard_t targets = ray_attacks[dir][from];
+      while (targets) {
+        const int to = pop_lsb(targets);
+        between_bb[from][to] =
+            ray_attacks[dir][from] & ray_attacks[opposite][to];
+        line_bb[from][to] = line;
+      }
+    }
+  }
+
+  use_pext = host_has_fast_pext();
+  init_slider_magics(bishop_magics, bishop_table,
+                     {NORTH_EAST, SOUTH_EAST, SOUTH_WEST, NORTH_WEST});
+  init_slider_magics(rook_magics, rook_table, {NORTH, EAST, SOUTH, WEST});
+  bitboard_flag = 1;
+}
+
+std::string string_from_bitboard(const bitboard_t bb) {
+  std::stringstream result;
+  for (int row = 7; row >= 0; --row) {
+    for (int col = 0; col < 8; ++col)
+      result << ((bb & square_bb(get_square_64_rc(row, col))) ? 'X' : '.');
+    result << "\n";
+  }
+  return result.str();
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <string>
+
+#include "assert.hpp"
+#include "square.hpp"
+#include "types.hpp"
+
+/* Bitboards use the 64-square indexing given by get_square_64, so bit 0 is A1,
+ * bit 7 is H1, bit 56 is A8 and bit 63 is H8. The mailbox (m_pieces) is still
+ * the source of truth for "what is on this square", while the bitboards answer
+ * "where are all the pieces of this type" and attack queries.
+ */
+
+enum : bitboard_t {
+  EMPTY_BB = 0ULL,
+  FILE_A_BB = 0x0101010101010101ULL,
+  FILE_H_BB = FILE_A_BB << 7,
+  RANK_1_BB = 0xFFULL,
+  RANK_2_BB = RANK_1_BB << 8,
+  RANK_3_BB = RANK_1_BB << 16,
+  RANK_6_BB = RANK_1_BB << 40,
+  RANK_7_BB = RANK_1_BB << 48,
+  RANK_8_BB = RANK_1_BB << 56,
+};
+
+// The eight ray directions, as indices into ray_attacks
+enum Direction {
+  NORTH = 0,
+  NORTH_EAST,
+  EAST,
+  SOUTH_EAST,
+  SOUTH,
+  SOUTH_WEST,
+  WEST,
+  NORTH_WEST,
+};
+
+constexpr inline bitboard_t square_bb(const int sq64) {
+  ASSERT(0 <= sq64 && sq64 < 64);
+  return bitboard_t(1) << sq64;
+}
+
+constexpr inline bitboard_t square_bb_120(const square_t sq) {
+  return square_bb(get_square_64(sq));
+}
+
+constexpr inline int popcount(const bitboard_t bb) { return std::popcount(bb); }
+
+constexpr inline int lsb(const bitboard_t bb) {
+  ASSERT(bb != 0);
+  return std::countr_zero(bb);
+}
+
+constexpr inline int msb(const bitboard_t bb) {
+  ASSERT(bb != 0);
+  return 63 - std::countl_zero(bb);
+}
+
+// Removes the least significant set bit and returns its index
+constexpr inline int pop_lsb(bitboard_t &bb) {
+  const int sq64 = lsb(bb);
+  bb &= bb - 1;
+  return sq64;
+}
+
+constexpr inline bitboard_t shift_north(const bitboard_t bb) { return bb << 8; }
+constexpr inline bitboard_t shift_south(const bitboard_t bb) { return bb >> 8; }
+
+// Every square attacked by the given side's pawns, where side is 0 for white
+// and 1 for black, as in pawn_attacks
+constexpr inline bitboard_t pawn_attacks_bb(const bitboard_t pawns,
+                                            const int side) {
+  const bitboard_t west = pawns & ~FILE_A_BB, east = pawns & ~FILE_H_BB;
+  return (side == 0) ? (west << 7) | (east << 9) : (west >> 9) | (east >> 7);
+}
+
+extern bitboard_t knight_attacks[64];
+extern bitboard_t king_attacks[64];
+extern bitboard_t pawn_attacks[2][64]; // Indexed by side, then square
+extern bitboard_t ray_attacks[8][64];  // Indexed by Direction, then square
+// The squares strictly between two squares on a common line, or 0
+extern bitboard_t between_bb[64][64];
+// The whole line (edge to edge) through two squares on a common line, or 0
+extern bitboard_t line_bb[64][64];
+
+// Sliding piece attacks are looked up in tables built by init_bitboards. The
+// relevant occupancy (the squares on the piece's rays, excluding the edges) is
+// mapped to a table index either with PEXT, on hosts with fast BMI2, or with a
+// magic multiplication otherwise. The choice is made once, at startup.
+struct SliderMagic {
+  bitboard_t mask;     // Relevant occupancy squares
+  bitboard_t magic;    // Multiplier for the magic index
+  bitboard_t *attacks; // This square's slice of the attack table
+  unsigned shift;      // 64 - popcount(mask)
+
+  inline unsigned index(const bitboard_t occ) const;
+};
+
+extern SliderMagic bishop_magics[64];
+extern SliderMagic rook_magics[64];
+extern bool use_pext;
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define HAS_PEXT_ASM
+// Emitted as inline assembly so that it can be inlined into code compiled
+// without -mbmi2. It is only ever executed when use_pext is set.
+inline bitboard_t pext(const bitboard_t value, const bitboard_t mask) {
+  bitboard_t result;
+  asm("pext %2, %1, %0" : "=r"(result) : "r"(value), "r"(mask));
+  return result;
+}
+#endif
+
+inline unsigned SliderMagic::index(const bitboard_t occ) const {
+#ifdef HAS_PEXT_ASM
+  if (use_pext)
+    return pext(occ, mask);
+#endif
+  return ((occ & mask) * magic) >> shift;
+}
+
+// Sliding attacks from sq64 given the occupied squares. The first blocker in
+// each direction is included in the result, so callers must mask out their own
+// pieces.
+inline bitboard_t bishop_attacks(const int sq64, const bitboard_t occ) {
+  const SliderMagic &entry = bishop_magics[sq64];
+  return entry.attacks[entry.index(occ)];
+}
+
+inline bitboard_t rook_attacks(const int sq64, const bitboard_t occ) {
+  const SliderMagic &entry = rook_magics[sq64];
+  return entry.attacks[entry.index(occ)];
+}
+
+inline bitboard_t queen_attacks(const int sq64, const bitboard_t occ) {
+  return bishop_attacks(sq64, occ) | rook_attacks(sq64, occ);
+}
+
+std::string string_from_bitboard(const bitboard_t bb);
+void init_bitboards() noexcept;
@@ -5,6 +5,7 @@
 #include "move.hpp"
 #include "opening_book.hpp"
 #include "piece.hpp"
+#include "piece_values.hpp"
 
 #include <algorithm>
 #include <iomanip>
@@ -17,6 +18,8 @@
 Board::Board(const std::string &fen) noexcept {
   m_pieces.fill(INVALID_PIECE);
   m_num_pieces.fill(0);
+  m_bitboards.fill(0);
+  m_side_bitboards.fill(0);
   for (unsigned piece = 0; piece < 16; ++piece) {
     m_positions[piece].fill(INVALID_SQUARE);
   }
@@ -49,6 +52,8 @@ Board::Board(const std::string &fen) noexcept {
                  piece_idx);
       m_positions[piece_idx][m_num_pieces[piece_idx]] = square_idx;
       m_num_pieces[piece_idx]++;
+      m_bitboards[piece_idx] |= square_bb_120(square_idx);
+      m_side_bitboards[get_side(piece_idx)] |= square_bb_120(square_idx);
       square_idx++;
       ASSERT(square_idx % 10 == 9 || valid_square(square_idx));
     }
@@ -134,7 +139,11 @@ Board::Board(const std::string &fen) noexcept {
   //
   // ASSERT_MSG(next_chr == end_ptr, "FEN string too long");
 
+  m_score = compute_score();
+  m_phase = compute_phase();
+  m_pawn_hash = compute_pawn_hash();
   m_hash = compute_hash();
+  m_has_legal_moves_hash = ~m_hash;
   validate_board();
 }
 
@@ -173,6 +182,20 @@ void Board::validate_board() const noexcept {
       }
     }
   }
+  std::array<bitboard_t, 2> side_bitboards = {0};
+  for (unsigned piece = 0; piece < 16; ++piece) {
+    bitboard_t expected = 0;
+    for (unsigned num = 0; num < m_num_pieces[piece]; ++num)
+      expected |= square_bb_120(m_positions[piece][num]);
+    ASSERT_MSG(m_bitboards[piece] == expected,
+               "Bitboard of piece %u inconsistent with m_positions", piece);
+    if (valid_piece(piece))
+      side_bitboards[get_side(piece)] |= expected;
+  }
+  ASSERT_MSG(m_side_bitboards[WHITE] == side_bitboards[WHITE],
+             "White occupancy bitboard inconsistent with m_positions");
+  ASSERT_MSG(m_side_bitboards[BLACK] == side_bitboards[BLACK],
+             "Black occupancy bitboard inconsistent with m_positions");
   ASSERT_MSG(0 <= m_castle_state && m_castle_state < 16,
              "Castle state (%u) out of range", m_castle_state);
   ASSERT_MSG(valid_square(m_en_passant) || m_en_passant == INVALID_SQUARE,
@@ -187,6 +210,14 @@ void Board::validate_board() const noexcept {
                 "En passant square (%s - %u) not on row 6 on white's turn",
                 string_from_square(m_en_passant).c_str(), m_en_passant);
 
+  ASSERT_MSG(m_score == compute_score(),
+             "Score (%d, %d) inconsistent with m_positions",
+             middlegame_value(m_score), endgame_value(m_score));
+  ASSERT_MSG(m_pawn_hash == compute_pawn_hash(),
+             "Pawn hash inconsistent with m_positions");
+  ASSERT_MSG(m_phase == compute_phase(),
+             "Phase (%d) inconsistent with m_num_pieces", m_phase);
+
   // Assert other king is not in check
   const piece_t king_piece =
       (m_side_to_move == BLACK) ? WHITE_KING : BLACK_KING;
@@ -263,6 +294,31 @@ std::string Board::fen() const noexcept {
   return result.str();
 }
 
+score_t Board::compute_score() const noexcept {
+  score_t res = 0;
+  for (piece_t piece = 0; piece < 16; ++piece) {
+    for (unsigned num = 0; num < m_num_pieces[piece]; ++num)
+      res += piece_values[piece][m_positions[piece][num]];
+  }
+  return res;
+}
+
+int Board::compute_phase() const noexcept {
+  int res = 0;
+  for (piece_t piece = 0; piece < 16; ++piece)
+    res += piece_phases[piece] * m_num_pieces[piece];
+  return res;
+}
+
+hash_t Board::compute_pawn_hash() const noexcept {
+  hash_t res = 0;
+  for (const piece_t piece : {WHITE_PAWN, BLACK_PAWN}) {
+    for (unsigned num = 0; num < m_num_pieces[piece]; ++num)
+      res ^= piece_hash[m_positions[piece][num]][piece];
+  }
+  return res;
+}
+
 hash_t Board::compute_hash() const noexcept {
   validate_board();
   hash_t res = 0;
@@ -272,13 +328,13 @@ hash_t Board::compute_hash() const noexcept {
                piece);
     ASSERT_MSG(valid_piece(piece) || piece_hash[sq][piece] == 0,
                "Invalid piece (%u) had non-zero hash (%llu)", piece,
-               piece_hash[sq][piece]);
+               (unsigned long long)piece_hash[sq][piece]);
     res ^= piece_hash[sq][piece];
   }
   res ^= castle_hash[m_castle_state];
   ASSERT_MSG(enpas_hash[INVALID_SQUARE] == 0,
              "Invalid square had non-zero hash (%llu)",
-             enpas_hash[INVALID_SQUARE]);
+             (unsigned long long)enpas_hash[INVALID_SQUARE]);
   res ^= enpas_hash[m_en_passant];
   res ^= (m_side_to_move * side_hash);
   return res;
@@ -348,12 +404,12 @@ std::string Board::to_string(const int side) const noexcept {
   // if (opening_book.query_all(*this).size() > 0) {
   //   result << "BOOK    : " << opening_book.book_moves_string(*this) << "\n";
   // }
-  if (!m_history.empty()) {
+  if (m_history_size > 0) {
     // Since the previous move was not played in the current position, we have
     // to revert to the last position before calling algebraic_notation, because
     // algebraic_notation needs to be aware of the legal moves at the time the
     // move was played (to disambiguate)
-    const move_t last_move = m_history.back().move;
+    const move_t last_move = history_entry(1).move;
     Board tmp(*this);
     tmp.unmake_move();
     result << "LAST MV : " << tmp.algebraic_notation(last_move) << "\n";
@@ -368,85 +424,72 @@ std::ostream &operator<<(std::ostream &os, const Board &board) noexcept {
 }
 
 bool Board::square_attacked(const square_t sq, const bool side) const noexcept {
-  const piece_t king_piece = (side == WHITE) ? WHITE_KING : BLACK_KING,
-                knight_piece = (side == WHITE) ? WHITE_KNIGHT : BLACK_KNIGHT,
-                pawn_piece = (side == WHITE) ? WHITE_PAWN : BLACK_PAWN;
-  const square_t king_square = m_positions[king_piece][0];
+  const piece_t offset = side << 3;
+  const int sq64 = get_square_64(sq);
+  const bitboard_t occ = occupied();
 
-  // Diagonals
-  for (const int offset : {-11, -9, 9, 11}) {
-    square_t cur_square = sq + offset;
-    if (king_square == cur_square)
-      return true;
-    while (valid_square(cur_square) && m_pieces[cur_square] == INVALID_PIECE)
-      cur_square += offset;
-    const piece_t cur_piece = m_pieces[cur_square];
-    // If the square is invalid, then the piece is invalid thus not on our side
-    if (get_side(cur_piece) == side && is_diag(cur_piece))
-      return true;
-  }
-
-  // Orthogonals
-  for (const int offset : {-10, -1, 1, 10}) {
-    square_t cur_square = sq + offset;
-    if (king_square == cur_square)
-      return true;
-    while (valid_square(cur_square) && m_pieces[cur_square] == INVALID_PIECE)
-      cur_square += offset;
-    const piece_t cur_piece = m_pieces[cur_square];
-    // If the square is invalid, then the piece is invalid thus not on our side
-    if (get_side(cur_piece) == side && is_ortho(cur_piece))
-      return true;
-  }
-
-  // Knights
-  for (const int offset : {-21, -19, -12, -8, 8, 12, 19, 21})
-    if (m_pieces[sq + offset] == knight_piece)
-      return true;
+  // A pawn of the given side attacks sq exactly when a pawn of the other side
+  // on sq would attack the pawn's square
+  if (pawn_attacks[!side][sq64] & m_bitboards[WHITE_PAWN | offset])
+    return true;
+  if (knight_attacks[sq64] & m_bitboards[WHITE_KNIGHT | offset])
+    return true;
+  if (king_attacks[sq64] & m_bitboards[WHITE_KING | offset])
+    return true;
 
-  // Pawns
-  const int offset1 = (side == WHITE) ? -9 : 9;
-  const int offset2 = (side == WHITE) ? -11 : 11;
-  if (m_pieces[sq + offset1] == pawn_piece ||
-      m_pieces[sq + offset2] == pawn_piece)
+  const bitboard_t queens = m_bitboards[WHITE_QUEEN | offset];
+  const bitboard_t diagonals = m_bitboards[WHITE_BISHOP | offset] | queens;
+  if (diagonals && (bishop_attacks(sq64, occ) & diagonals))
+    return true;
+  const bitboard_t orthogonals = m_bitboards[WHITE_ROOK | offset] | queens;
+  if (orthogonals && (rook_attacks(sq64, occ) & orthogonals))
     return true;
 
   return false;
 }
 
+bitboard_t Board::attackers_to(const int sq64, const bool side,
+                               const bitboard_t occ) const noexcept {
+  const piece_t offset = side << 3;
+  const bitboard_t queens = m_bitboards[WHITE_QUEEN | offset];
+  return (pawn_attacks[!side][sq64] & m_bitboards[WHITE_PAWN | offset]) |
+         (knight_attacks[sq64] & m_bitboards[WHITE_KNIGHT | offset]) |
+         (king_attacks[sq64] & m_bitboards[WHITE_KING | offset]) |
+         (bishop_attacks(sq64, occ) &
+          (m_bitboards[WHITE_BISHOP | offset] | queens)) |
+         (rook_attacks(sq64, occ) & (m_bitboards[WHITE_ROOK | offset] | queens));
+}
+
 bool Board::king_in_check() const noexcept {
   const piece_t king_piece = m_side_to_move << 3 | WHITE_KING;
   return square_attacked(m_positions[king_piece][0], !m_side_to_move);
 }
 
 constexpr bool Board::insufficient_material() const noexcept {
-  if (m_num_pieces[WHITE_PAWN] > 0 || m_num_pieces[BLACK_PAWN] > 0 ||
-      m_num_pieces[WHITE_QUEEN] > 0 || m_num_pieces[BLACK_QUEEN] > 0 ||
-      m_num_pieces[WHITE_ROOK] > 0 || m_num_pieces[BLACK_ROOK] > 0 ||
-      m_num_pieces[WHITE_KNIGHT] > 1 || m_num_pieces[WHITE_BISHOP] > 1 ||
-      m_num_pieces[BLACK_KNIGHT] > 1 || m_num_pieces[BLACK_BISHOP] > 1)
-    return false;
-  if (m_num_pieces[WHITE_KNIGHT] > 0 && m_num_pieces[WHITE_BISHOP] > 0)
-    return false;
-  if (m_num_pieces[BLACK_KNIGHT] > 0 && m_num_pieces[BLACK_BISHOP] > 0)
+  const bitboard_t pawns_and_majors =
+      m_bitboards[WHITE_PAWN] | m_bitboards[BLACK_PAWN] |
+      m_bitboards[WHITE_ROOK] | m_bitboards[BLACK_ROOK] |
+      m_bitboards[WHITE_QUEEN] | m_bitboards[BLACK_QUEEN];
+  if (pawns_and_majors)
     return false;
-  return true;
-}
 
-bool Board::is_endgame() const noexcept {
-  // Return true if neither side has a queen
-  if (m_num_pieces[WHITE_QUEEN] == 0 && m_num_pieces[BLACK_QUEEN] == 0)
+  // Only kings and minor pieces remain. If every minor piece is a bishop and
+  // they all stand on the same colour of square, nobody can ever be mated.
+  constexpr bitboard_t light_squares = 0x55AA55AA55AA55AAULL;
+  const bitboard_t bishops =
+      m_bitboards[WHITE_BISHOP] | m_bitboards[BLACK_BISHOP];
+  const bitboard_t knights =
+      m_bitboards[WHITE_KNIGHT] | m_bitboards[BLACK_KNIGHT];
+  if (knights == 0 &&
+      ((bishops & light_squares) == 0 || (bishops & ~light_squares) == 0))
     return true;
-  // Otherwise, if each side which has a queen has at most one minor piece
-  const bool white_has_no_queen_or_one_minor =
-      m_num_pieces[WHITE_QUEEN] == 0 ||
-      (m_num_pieces[WHITE_ROOK] == 0 &&
-       m_num_pieces[WHITE_KNIGHT] + m_num_pieces[WHITE_BISHOP] <= 1);
-  const bool black_has_no_queen_or_one_minor =
-      m_num_pieces[BLACK_QUEEN] == 0 ||
-      (m_num_pieces[BLACK_ROOK] == 0 &&
-       m_num_pieces[BLACK_KNIGHT] + m_num_pieces[BLACK_BISHOP] <= 1);
-  return white_has_no_queen_or_one_minor && black_has_no_queen_or_one_minor;
+
+  // Otherwise each side may have at most one minor piece
+  const bitboard_t white_minors =
+      m_bitboards[WHITE_BISHOP] | m_bitboards[WHITE_KNIGHT];
+  const bitboard_t black_minors =
+      m_bitboards[BLACK_BISHOP] | m_bitboards[BLACK_KNIGHT];
+  return popcount(white_minors) <= 1 && popcount(black_minors) <= 1;
 }
 
 bool Board::is_drawn() const noexcept {
@@ -459,6 +502,13 @@ inline void Board::remove_piece(const square_t sq) noexcept {
   ASSERT_MSG(valid_piece(piece), "Removing invalid piece (%u)!", piece);
   m_pieces[sq] = INVALID_PIECE;
   m_hash ^= piece_hash[sq][piece];
+  if (is_pawn(piece))
+    m_pawn_hash ^= piece_hash[sq][piece];
+  m_score -= piece_values[piece][sq];
+  m_phase -= piece_phases[piece];
+  const bitboard_t sq_bb = square_bb_120(sq);
+  m_bitboards[piece] ^= sq_bb;
+  m_side_bitboards[get_side(piece)] ^= sq_bb;
   auto &piece_list = m_positions[piece];
   const int num_pieces = m_num_pieces[piece];
   m_num_pieces[piece]--;
@@ -480,6 +530,13 @@ inline void Board::add_piece(const square_t sq, const piece_t piece) noexcept {
   m_positions[piece][m_num_pieces[piece]] = sq;
   m_num_pieces[piece]++;
   m_hash ^= piece_hash[sq][piece];
+  if (is_pawn(piece))
+    m_pawn_hash ^= piece_hash[sq][piece];
+  m_score += piece_values[piece][sq];
+  m_phase += piece_phases[piece];
+  const bitboard_t sq_bb = square_bb_120(sq);
+  m_bitboards[piece] |= sq_bb;
+  m_side_bitboards[get_side(piece)] |= sq_bb;
 }
 
 inline void Board::set_castle_state(const castle_t state) noexcept {
@@ -508,6 +565,12 @@ inline void Board::move_piece(const square_t from, const square_t to) noexcept {
   ASSERT_MSG(this_idx != last_idx, "Moved piece not in piece_list");
   *this_idx = to;
   m_hash ^= piece_hash[from][piece] ^ piece_hash[to][piece];
+  if (is_pawn(piece))
+    m_pawn_hash ^= piece_hash[from][piece] ^ piece_hash[to][piece];
+  m_score += piece_values[piece][to] - piece_values[piece][from];
+  const bitboard_t from_to_bb = square_bb_120(from) | square_bb_120(to);
+  m_bitboards[piece] ^= from_to_bb;
+  m_side_bitboards[get_side(piece)] ^= from_to_bb;
 }
 
 inline void Board::update_castling(const square_t from,
@@ -519,6 +582,25 @@ inline void Board::update_castling(const square_t from,
   m_hash ^= castle_hash[m_castle_state];
 }
 
+inline void Board::push_history(const history_t &entry) noexcept {
+  m_history[m_half_move % HISTORY_SIZE] = entry;
+  m_history_size = std::min(m_history_size + 1, unsigned(HISTORY_SIZE));
+  m_half_move++;
+}
+
+inline history_t Board::pop_history() noexcept {
+  // Checked in every build: past the recorded history, the ring buffer would
+  // hand back entries that later moves have overwritten
+  if (m_history_size == 0) [[unlikely]] {
+    ERROR("Unmaking past the recorded history");
+    exit(1);
+  }
+  ASSERT_MSG(m_half_move > 0, "Unmaking first move");
+  m_history_size--;
+  m_half_move--;
+  return m_history[m_half_move % HISTORY_SIZE];
+}
+
 inline void Board::switch_colours() noexcept {
   INFO("Switching colours");
   m_side_to_move ^= 1;
@@ -543,10 +625,7 @@ bool Board::make_move(const move_t move) noexcept {
              string_from_move(move).c_str(), to_string().c_str());
 
   // Bookkeeping
-  const history_t entry = {move, m_castle_state, m_en_passant, m_fifty_move,
-                           m_hash};
-  m_history.push_back(entry);
-  m_half_move++;
+  push_history({m_hash, move, m_fifty_move, m_en_passant, m_castle_state});
 
   update_castling(from, to);
   if (move_promoted(move)) {
@@ -623,17 +702,14 @@ bool Board::make_move(const move_t move) noexcept {
 void Board::unmake_move() noexcept {
   INFO("======================================================================="
        "==============");
-  ASSERT_MSG(!m_history.empty(),
+  ASSERT_MSG(m_history_size > 0,
              "Trying to unmake move from starting position");
-  const history_t entry = m_history.back();
-  m_history.pop_back();
+  const history_t entry = pop_history();
   const move_t move = entry.move;
   const hash_t last_hash = entry.hash;
   set_castle_state(entry.castle_state);
   set_en_passant(entry.en_passant);
   m_fifty_move = entry.fifty_move;
-  ASSERT_MSG(m_half_move > 0, "Unmaking first move");
-  m_half_move--;
   switch_colours();
   const bool cur_side = m_side_to_move;
 
@@ -688,11 +764,9 @@ void Board::make_null_move() noexcept {
   ASSERT(!king_in_check());
 
   // Bookkeeping
-  m_history.push_back(
-      {NULL_MOVE, m_castle_state, m_en_passant, m_fifty_move, m_hash});
+  push_history({m_hash, NULL_MOVE, m_fifty_move, m_en_passant, m_castle_state});
 
   set_en_passant(INVALID_SQUARE);
-  m_half_move++;
   m_fifty_move++;
 
   switch_colours();
@@ -702,11 +776,9 @@ void Board::make_null_move() noexcept {
 void Board::unmake_null_move() noexcept {
   validate_board();
 
-  m_half_move--;
   m_fifty_move--;
 
-  const history_t entry = m_history.back();
-  m_history.pop_back();
+  const history_t entry = pop_history();
   ASSERT_MSG(entry.move == NULL_MOVE,
              "Unmaking null move when previous move was not null");
   set_en_passant(entry.en_passant);
@@ -728,14 +800,12 @@ std::string Board::algebraic_notation(const move_t move) const {
   const square_t from_square = move_from(move);
   const square_t to_square = move_to(move);
 
-  const std::vector<move_t> move_list = legal_moves();
-  std::vector<move_t> same_piece_and_target;
-  std::copy_if(move_list.begin(), move_list.end(),
-               std::back_inserter(same_piece_and_target),
-               [to_square, moved_piece, move](const move_t list_move) {
-                 return move != list_move && move_to(list_move) == to_square &&
-                        ::moved_piece(list_move) == moved_piece;
-               });
+  MoveList same_piece_and_target;
+  for (const move_t list_move : legal_moves()) {
+    if (move != list_move && move_to(list_move) == to_square &&
+        ::moved_piece(list_move) == moved_piece)
+      same_piece_and_target.push_back(list_move);
+  }
 
   const bool ambiguous = same_piece_and_target.size() > 0;
   bool ambiguous_file = false;
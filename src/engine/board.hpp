@@ -1,6 +1,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <map>
 #include <ostream>
@@ -9,44 +10,83 @@
 #include <unordered_set>
 #include <vector>
 
+#include "bitboard.hpp"
 #include "castle_state.hpp"
 #include "hash.hpp"
+#include "move_list.hpp"
 #include "piece.hpp"
+#include "piece_values.hpp"
 #include "square.hpp"
 
 // NOTE: The max number of any type of piece in play. Keep as small as possible.
 enum { MAX_PIECE_FREQ = 10 };
-// NOTE: The max number of possible moves in any position.
-// SOURCE: https://www.stmintz.com/ccc/index.php?id=424966 (cites 218)
-enum { MAX_POSITION_MOVES = 256 };
-// NOTE: The initial size of the reserved move list when generating moves
-//       Should be close to the twice true average branching factor, which is 35
-enum { START_POSITION_MOVES = 64 };
 
 enum { WHITE = 0, BLACK = 1, INVALID_SIDE = -1 };
 
+// NOTE: The number of plies of history kept by a board. Repetitions never
+// look back past the last capture or pawn move (the game is drawn 100 plies
+// later), and the search only unmakes moves it made itself, so older entries
+// can safely be overwritten. Must be a power of two.
+enum { HISTORY_SIZE = 128 };
+
+// Which moves the move generators produce. Tactical moves are the captures
+// and promotions, which quiescence search looks at, and quiet moves the rest.
+enum MoveGenType { ALL_MOVES, TACTICAL_MOVES, QUIET_MOVES };
+
 struct history_t {
+  hash_t hash;
   move_t move;
-  castle_t castle_state;
-  square_t en_passant;
   unsigned int fifty_move;
-  hash_t hash;
+  square_t en_passant;
+  castle_t castle_state;
 };
 
 struct Board {
   std::array<piece_t, 120> m_pieces;
   std::array<std::array<square_t, MAX_PIECE_FREQ>, 16> m_positions;
   std::array<unsigned, 16> m_num_pieces;
+  std::array<bitboard_t, 16> m_bitboards;    // Indexed by piece
+  std::array<bitboard_t, 2> m_side_bitboards; // Indexed by side
   bool m_side_to_move;
   castle_t m_castle_state;
   square_t m_en_passant;
   unsigned int m_fifty_move;
   unsigned int m_half_move;
   hash_t m_hash;
-  std::vector<history_t> m_history;
+  hash_t m_pawn_hash; // The hash of the pawns alone, for the pawn table
+  // The material and piece-square values of every piece, from white's
+  // perspective, and the game phase of the pieces on the board. Both are kept
+  // up to date as pieces are added, removed and moved.
+  score_t m_score;
+  int m_phase;
+  // A ring buffer of the last HISTORY_SIZE plies, where the entry for the
+  // position at half move h lives at m_history[h % HISTORY_SIZE]. Keeping it
+  // inline makes copying a board constant-size however long the game is.
+  std::array<history_t, HISTORY_SIZE> m_history;
+  unsigned int m_history_size = 0; // The number of valid entries
+  // has_legal_moves is asked several times per search node, so its last answer
+  // is kept together with the hash of the position it was computed for
+  mutable hash_t m_has_legal_moves_hash;
+  mutable bool m_has_legal_moves;
 
   hash_t compute_hash() const noexcept;
+  hash_t compute_pawn_hash() const noexcept;
+  score_t compute_score() const noexcept;
+  int compute_phase() const noexcept;
   void validate_board() const noexcept;
+  bitboard_t pinned_pieces(const int king64) const noexcept;
+  bool gives_slider_check(const move_t move, const int king64,
+                          const int from64, const int to64,
+                          const piece_t piece) const noexcept;
+  // The history entry pushed 'plies' half moves ago (1 is the last move)
+  constexpr inline const history_t &
+  history_entry(const unsigned plies) const noexcept {
+    ASSERT(0 < plies && plies <= m_history_size);
+    return m_history[(m_half_move - plies) % HISTORY_SIZE];
+  }
+  inline void push_history(const history_t &entry) noexcept;
+  inline history_t pop_history() noexcept;
+  bool compute_has_legal_moves() const noexcept;
 
 public:
   constexpr static const char *startFEN =
@@ -54,14 +94,33 @@ public:
 
   Board(const std::string &fen = Board::startFEN) noexcept;
 
-  constexpr inline hash_t hash() const noexcept {
+  inline hash_t hash() const noexcept {
     ASSERT_MSG(m_hash == compute_hash(), "Hash invariant broken");
     return m_hash;
   }
+  inline hash_t pawn_hash() const noexcept {
+    ASSERT_MSG(m_pawn_hash == compute_pawn_hash(),
+               "Pawn hash invariant broken");
+    return m_pawn_hash;
+  }
+  // The packed material and piece-square score from white's perspective
+  constexpr inline score_t score() const noexcept { return m_score; }
+  constexpr inline int phase() const noexcept { return m_phase; }
   constexpr inline piece_t piece_at(const square_t square) const noexcept {
     ASSERT(0 <= square && square < 120);
     return m_pieces[square];
   }
+  constexpr inline bitboard_t pieces(const piece_t piece) const noexcept {
+    ASSERT(valid_piece(piece));
+    return m_bitboards[piece];
+  }
+  constexpr inline bitboard_t side_pieces(const int side) const noexcept {
+    ASSERT(side == WHITE || side == BLACK);
+    return m_side_bitboards[side];
+  }
+  constexpr inline bitboard_t occupied() const noexcept {
+    return m_side_bitboards[WHITE] | m_side_bitboards[BLACK];
+  }
   constexpr inline bool can_castle(const int castle_flag) const noexcept {
     ASSERT(castle_flag == WHITE_LONG || castle_flag == WHITE_SHORT ||
            castle_flag == BLACK_LONG || castle_flag == BLACK_SHORT);
@@ -72,13 +131,21 @@ public:
   std::string to_string(const int side = WHITE) const noexcept;
 
   bool square_attacked(const square_t sq, const bool side) const noexcept;
+  // The pieces of the given side which attack sq64, with sliders blocked by
+  // the squares in occ rather than the current occupancy
+  bitboard_t attackers_to(const int sq64, const bool side,
+                          const bitboard_t occ) const noexcept;
   bool king_in_check() const noexcept;
 
-  std::vector<move_t>
-  pseudo_moves(const bool generate_quiet_moves = true) const noexcept;
-  std::vector<move_t>
-  legal_moves(const bool generate_quiet_moves = true) const noexcept;
+  MoveList pseudo_moves(const MoveGenType type = ALL_MOVES) const noexcept;
+  MoveList legal_moves(const MoveGenType type = ALL_MOVES) const noexcept;
   bool has_legal_moves() const noexcept;
+  // Whether a move from elsewhere (the transposition table, or another
+  // position entirely) is legal here, without generating every legal move
+  bool is_legal(const move_t move) const noexcept;
+  // Whether a legal move checks the opponent, directly or by discovery,
+  // without making it
+  bool gives_check(const move_t move) const noexcept;
 
   constexpr bool has_major_pieces(const int side) const noexcept {
     const piece_t rook = (side == WHITE) ? WHITE_ROOK : BLACK_ROOK;
@@ -86,6 +153,15 @@ public:
     return m_num_pieces[rook] + m_num_pieces[queen] > 0;
   }
 
+  // Whether the side has anything besides pawns and its king, in which case
+  // it is very rarely in zugzwang
+  constexpr bool has_non_pawn_material(const int side) const noexcept {
+    const piece_t knight = (side == WHITE) ? WHITE_KNIGHT : BLACK_KNIGHT;
+    const piece_t bishop = (side == WHITE) ? WHITE_BISHOP : BLACK_BISHOP;
+    return has_major_pieces(side) ||
+           m_num_pieces[knight] + m_num_pieces[bishop] > 0;
+  }
+
   constexpr int num_pieces() const noexcept {
     int result = 0;
     for (piece_t piece = 0; piece < 16; ++piece) {
@@ -121,9 +197,12 @@ public:
 
   constexpr bool insufficient_material() const noexcept;
   constexpr inline int count_repetitions() const noexcept {
+    // Positions before the last irreversible move can't repeat, and positions
+    // from before the start of the recorded history are unknown
+    const unsigned lookback = std::min(m_fifty_move, m_history_size);
     int result = 0;
-    for (size_t idx = m_half_move - m_fifty_move; idx < m_half_move; ++idx) {
-      if (m_history[idx].hash == m_hash)
+    for (unsigned plies = 1; plies <= lookback; ++plies) {
+      if (history_entry(plies).hash == m_hash)
         result++;
     }
     return result;
@@ -135,7 +214,6 @@ public:
     return count_repetitions() >= 2;
   }
   bool is_drawn() const noexcept;
-  bool is_endgame() const noexcept;
   inline void remove_piece(const square_t sq) noexcept;
   inline void add_piece(const square_t sq, const piece_t piece) noexcept;
   inline void set_castle_state(const castle_t state) noexcept;
@@ -143,6 +221,8 @@ public:
   inline void move_piece(const square_t from, const square_t to) noexcept;
   inline void update_castling(const square_t from, const square_t to) noexcept;
   inline void switch_colours() noexcept;
+  // Only the last HISTORY_SIZE moves, and none from before the board was set
+  // up, can be unmade: unmaking past them exits with an error
   bool make_move(const move_t move) noexcept;
   void unmake_move() noexcept;
   void make_null_move() noexcept;
@@ -152,7 +232,6 @@ public:
 };
 
 std::ostream &operator<<(std::ostream &os, const Board &board) noexcept;
-void print_move_list(const std::vector<move_t> &move_list);
-void print_simple_move_list(const std::vector<move_t> &move_list);
-void print_algebraic_move_list(const Board &board,
-                               const std::vector<move_t> &move_list);
+void print_move_list(const MoveList &move_list);
+void print_simple_move_list(const MoveList &move_list);
+void print_algebraic_move_list(const Board &board, const MoveList &move_list);
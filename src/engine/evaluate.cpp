@@ -1,9 +1,13 @@
 
 #include "evaluate.hpp"
+#include "attack_map.hpp"
 #include "board.hpp"
 #include "move.hpp"
+#include "move_picker.hpp"
+#include "pawn_structure.hpp"
 #include "perf_counter.hpp"
 #include "piece_values.hpp"
+#include "search_params.hpp"
 #include "square.hpp"
 #include "transposition_table.hpp"
 #include "uci_protocol.hpp"
@@ -12,13 +16,20 @@
 #include <functional>
 #include <iomanip>
 #include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
 
-#define NULL_MOVE_R 3
+// The half-width of the first aspiration window, in centipawns, and the depth
+// from which iterative deepening starts using them
+#define ASPIRATION_WINDOW 50
+#define ASPIRATION_MIN_DEPTH 4
 
 static bool should_stop(const SearchInfo &info) {
   if (info.is_stopped || info.has_quit) [[unlikely]]
     return true;
-  if (!info.infinite && seconds_since(info.start_time) > info.seconds_to_search)
+  if (!info.infinite &&
+      seconds_since(info.start_time) > info.time_manager.maximum_seconds())
     return true;
   return false;
 }
@@ -28,21 +39,15 @@ static bool should_stop(const SearchInfo &info) {
 // negative evaluations
 int evaluate_piece(const Board &board, const piece_t piece,
                    const square_t square) {
-  if (board.is_endgame()) {
-    if (piece == WHITE_KING) {
-      return piece_values[WHITE_ENDGAME_KING][square];
-    } else if (piece == BLACK_KING) {
-      return piece_values[BLACK_ENDGAME_KING][square];
-    }
-  }
-  return piece_values[piece][square];
+  return taper(piece_values[piece][square], board.phase());
 }
 
 // Given a board and a (not necessarily legal) move, returns a heuristic
 // evaluation of the move from the perspective of the side to move.
 //
 // Captured and promoted pieces significantly boost this score.
-int evaluate_move(Board &board, const TableEntry entry, const move_t move) {
+int evaluate_move(const Board &board, const TableEntry entry,
+                  const move_t move) {
   perf_counter.increment("evaluate_move");
 
   int value = 0;
@@ -56,10 +61,7 @@ int evaluate_move(Board &board, const TableEntry entry, const move_t move) {
   }
 
   // Checks get +10000
-  board.make_move(move);
-  const bool is_check = board.king_in_check();
-  board.unmake_move();
-  if (is_check)
+  if (board.gives_check(move))
     value += 10000;
 
   // PV move gets +20000
@@ -69,28 +71,18 @@ int evaluate_move(Board &board, const TableEntry entry, const move_t move) {
   return value;
 }
 
-void order_moves(const Board &board, std::vector<move_t> &moves) {
+void order_moves(const Board &board, MoveList &moves) {
   perf_counter.increment("order_moves");
-  std::vector<std::pair<int, move_t>> eval_legal_moves;
-  eval_legal_moves.reserve(moves.size());
   const TableEntry entry = transposition_table.query(board.hash());
-  Board tmp(board);
-  for (const move_t move : moves) {
-    const int value = evaluate_move(tmp, entry, move);
-    eval_legal_moves.emplace_back(value, move);
-  }
-  std::sort(eval_legal_moves.begin(), eval_legal_moves.end(),
-            std::greater<std::pair<int, move_t>>());
-  for (size_t idx = 0; idx < moves.size(); ++idx) {
-    moves[idx] = eval_legal_moves[idx].second;
-  }
+  for (ScoredMove &move : moves)
+    move.score = evaluate_move(board, entry, move.move);
+  moves.sort();
 }
 
-std::vector<move_t>
-get_sorted_legal_moves(const Board &board,
-                       const bool generate_quiet_moves = true) {
+MoveList get_sorted_legal_moves(Board &board,
+                                const MoveGenType type = ALL_MOVES) {
   perf_counter.increment("get_sorted_legal_moves");
-  auto legal_moves = board.legal_moves(generate_quiet_moves);
+  MoveList legal_moves = board.legal_moves(type);
   order_moves(board, legal_moves);
   return legal_moves;
 }
@@ -116,6 +108,57 @@ void print_piece_evaluations(const Board &board) {
   std::cout << result.str() << std::endl;
 }
 
+score_t evaluate_pieces(const Board &board) {
+  static constexpr score_t BISHOP_PAIR = make_score(30, 50);
+  static constexpr score_t ROOK_OPEN_FILE = make_score(25, 10);
+  static constexpr score_t ROOK_SEMI_OPEN_FILE = make_score(12, 5);
+  static constexpr score_t QUEEN_OPEN_FILE = make_score(5, 5);
+  static constexpr score_t QUEEN_SEMI_OPEN_FILE = make_score(2, 2);
+  static constexpr int MAX_KING_DANGER = 400;
+
+  const AttackMap attacks(board);
+  const bitboard_t pawns =
+      board.pieces(WHITE_PAWN) | board.pieces(BLACK_PAWN);
+  score_t result = 0;
+  for (const int side : {WHITE, BLACK}) {
+    const piece_t offset = (side == WHITE) ? 0 : 8;
+    const bitboard_t own_pawns = board.pieces(WHITE_PAWN | offset);
+    score_t side_result = attacks.mobility[side];
+
+    if (board.m_num_pieces[WHITE_BISHOP | offset] >= 2)
+      side_result += BISHOP_PAIR;
+
+    // Files without pawns, or without friendly pawns to block them
+    const auto file_bonus = [&](const piece_t piece, const score_t open,
+                                const score_t semi_open) {
+      score_t bonus = 0;
+      bitboard_t pieces = board.pieces(piece);
+      while (pieces) {
+        const bitboard_t file = FILE_A_BB << (pop_lsb(pieces) % 8);
+        if (!(file & pawns))
+          bonus += open;
+        else if (!(file & own_pawns))
+          bonus += semi_open;
+      }
+      return bonus;
+    };
+    side_result +=
+        file_bonus(WHITE_ROOK | offset, ROOK_OPEN_FILE, ROOK_SEMI_OPEN_FILE);
+    side_result +=
+        file_bonus(WHITE_QUEEN | offset, QUEEN_OPEN_FILE, QUEEN_SEMI_OPEN_FILE);
+
+    // A lone attacker rarely gets anywhere, but the danger grows quickly with
+    // the number and strength of the pieces bearing down on the king
+    if (attacks.king_attackers[side] >= 2) {
+      const int weight = attacks.king_attack_weight[side];
+      side_result += make_score(std::min(weight * weight, MAX_KING_DANGER), 0);
+    }
+
+    result += (side == WHITE) ? side_result : -side_result;
+  }
+  return result;
+}
+
 int static_evaluate_board(const Board &board, const int side) {
   perf_counter.increment("SE");
 
@@ -123,34 +166,20 @@ int static_evaluate_board(const Board &board, const int side) {
 
   // Evaluate everything from white's perspective and take into account side
   // at the end
-  int white_eval = 0;
-  if (board.is_repeated() || board.is_drawn()) {
-    white_eval = 0;
-  } else if (!board.has_legal_moves()) {
-    white_eval = board.king_in_check() ? -MATE : 0;
-  } else {
-    // Loop straight through the invalid pieces to avoid branching: there
-    // should be 0 of them and their piece value is 0.
-    for (piece_t piece = 0; piece < 16; ++piece) {
-      const size_t num_pieces = board.m_num_pieces[piece];
-      for (size_t piece_idx = 0; piece_idx < num_pieces; ++piece_idx) {
-        const square_t piece_square = board.m_positions[piece][piece_idx];
-        white_eval += evaluate_piece(board, piece, piece_square);
-      }
-    }
-  }
+  // The material and piece-square values are kept up to date by the board,
+  // and the pawn structure is mostly cached
+  const int white_eval = taper(
+      board.score() + evaluate_pawns(board) + evaluate_pieces(board),
+      board.phase());
   return (side == WHITE) ? white_eval : -white_eval;
 }
 
-inline std::string to_string(const int num, const int num_digits) {
-  std::stringstream ss;
-  ss << std::setw(num_digits) << std::setfill('0') << num;
-  return ss.str();
-}
-
+// Quiet checks are searched too if search_quiet_checks is set, which the main
+// search does at its horizon so that mates just beyond it are seen
 int quiescence_search(SearchInfo &info, Board &board, const int ply,
                       int alpha = -SCORE_INFINITY,
-                      const int beta = SCORE_INFINITY) {
+                      const int beta = SCORE_INFINITY,
+                      const bool search_quiet_checks = false) {
 
   // std::cout << "QS " << std::setw(16) << std::setfill('0') << std::hex
   //           << board.hash() << std::dec << "\t\t";
@@ -172,23 +201,54 @@ int quiescence_search(SearchInfo &info, Board &board, const int ply,
     return 0;
   }
 
-  const int stand_pat_eval = static_evaluate_board(board, board.m_side_to_move);
-  if (stand_pat_eval >= beta)
+  // Results of earlier quiescence searches are stored at depth 0, so any entry
+  // bounds the score here, and saves evaluating the position again
+  const TableEntry entry = transposition_table.query(board.hash());
+  if (entry.type == NodeType::Exact ||
+      (entry.type == NodeType::Upper && entry.value <= alpha) ||
+      (entry.type == NodeType::Lower && entry.value >= beta)) {
+    perf_counter.increment("QS_lookup");
+    return entry.value;
+  }
+
+  const int stand_pat_eval =
+      (entry.static_eval != NO_EVAL)
+          ? entry.static_eval
+          : static_evaluate_board(board, board.m_side_to_move);
+  if (stand_pat_eval >= beta) {
+    transposition_table.insert(board, 0, 0, stand_pat_eval, Lower,
+                               stand_pat_eval);
     return stand_pat_eval;
+  }
+  const int start_alpha = alpha;
   alpha = std::max(alpha, stand_pat_eval);
 
-  const auto legal_captures = get_sorted_legal_moves(board, false);
-  for (const move_t next_move : legal_captures) {
+  move_t best_move = 0;
+  MovePicker picker(board, 0, {}, false, search_quiet_checks);
+  for (move_t next_move = picker.next(); next_move; next_move = picker.next()) {
+    // Captures which lose material by static exchange can't raise the score
+    // above the stand pat, so stop once the picker reaches them
+    if (picker.stage() == MovePicker::BAD_CAPTURES)
+      break;
     board.make_move(next_move);
     const int value = -quiescence_search(info, board, ply + 1, -beta, -alpha);
     board.unmake_move();
 
     if (info.is_stopped) [[unlikely]]
       return 0;
-    if (value >= beta)
+    if (value >= beta) {
+      transposition_table.insert(board, next_move, 0, value, Lower,
+                                 stand_pat_eval);
       return value;
-    alpha = std::max(alpha, value);
+    }
+    if (value > alpha) {
+      alpha = value;
+      best_move = next_move;
+    }
   }
+  transposition_table.insert(board, best_move, 0, alpha,
+                             (alpha > start_alpha) ? Exact : Upper,
+                             stand_pat_eval);
   return alpha;
 }
 
@@ -242,24 +302,9 @@ int alpha_beta(SearchInfo &info, Board &board, const int ply, int depth,
     }
   }
 
-  if (board.king_in_check()) {
+  const bool in_check = board.king_in_check();
+  if (in_check)
     depth++;
-  } else {
-    if (do_null_move && ply > 0 && depth >= 1 + NULL_MOVE_R &&
-        board.has_major_pieces(board.m_side_to_move)) {
-      // Do null move pruning
-      board.make_null_move();
-      const int value =
-          -alpha_beta(info, board, ply + 1, depth - 1 - NULL_MOVE_R, -beta,
-                      -beta + 1, false);
-      board.unmake_null_move();
-
-      if (info.is_stopped) [[unlikely]]
-        return 0;
-      if (value >= beta)
-        return beta;
-    }
-  }
 
   // if (ply > 1) {
   //   std::cout << "AB " << std::setw(16) << std::setfill('0') << std::hex
@@ -274,9 +319,10 @@ int alpha_beta(SearchInfo &info, Board &board, const int ply, int depth,
     return board.king_in_check() ? -mate_in(ply) : 0;
   } else if (ply > 0 && (board.is_drawn() || board.is_repeated())) {
     return 0;
-  } else if (depth <= 0) {
-    // If we've reached the search depth, perform quiescence_search instead
-    return quiescence_search(info, board, ply, alpha, beta);
+  } else if (depth <= 0 || ply >= MAX_SEARCH_PLY) {
+    // If we've reached the search depth, perform quiescence_search instead,
+    // looking for quiet checks too on the principal variation
+    return quiescence_search(info, board, ply, alpha, beta, beta - alpha > 1);
   }
 
   // Consult the transposition table: grab a cached evaluation and the best
@@ -298,93 +344,327 @@ int alpha_beta(SearchInfo &info, Board &board, const int ply, int depth,
 
   perf_counter.increment("AB_");
 
+  // The static evaluation is stored in the transposition table alongside the
+  // search results, so it is only computed on a position's first visit. The
+  // position is improving if it evaluates better than it did two plies ago,
+  // in which case the pruning below is less aggressive.
+  const int side = board.m_side_to_move;
+  int static_eval = NO_EVAL;
+  if (!in_check) {
+    static_eval = (entry.static_eval != NO_EVAL)
+                      ? entry.static_eval
+                      : static_evaluate_board(board, side);
+  }
+  SearchStackEntry &stack_entry = info.stack[ply];
+  stack_entry.in_check = in_check;
+  stack_entry.static_eval = static_eval;
+  const bool improving = !in_check && ply >= 2 &&
+                         !info.stack[ply - 2].in_check &&
+                         static_eval > info.stack[ply - 2].static_eval;
+
+  // Shallow pruning relies on the static evaluation, and is only done outside
+  // the principal variation, where an exact score is not needed
+  const bool is_pv = beta - alpha > 1;
+  const bool can_prune = !is_pv && !in_check && ply > 0;
+
+  // Reverse futility pruning: far enough above beta that no reply will bring
+  // the score back down
+  if (can_prune && depth <= search_params.reverse_futility_max_depth &&
+      std::abs(beta) < MATE_THRESHOLD &&
+      static_eval - search_params.reverse_futility_margin *
+                            (depth - improving) >=
+          beta) {
+    perf_counter.increment("AB_reverse_futility_pruned");
+    return static_eval;
+  }
+
+  // Null move pruning: if passing still beats beta in a reduced search, so
+  // will the best move. Passing is only sound when some move keeps the
+  // position at least as good, which fails in zugzwang, so it is skipped with
+  // only pawns left and double-checked by a search without it at high depth.
+  if (can_prune && do_null_move &&
+      depth >= search_params.null_move_min_depth && static_eval >= beta &&
+      std::abs(beta) < MATE_THRESHOLD && board.has_non_pawn_material(side)) {
+    const int reduction =
+        search_params.null_move_base +
+        depth / search_params.null_move_depth_divisor +
+        std::min((static_eval - beta) / search_params.null_move_eval_divisor,
+                 search_params.null_move_eval_max);
+    const int null_depth = std::max(depth - 1 - reduction, 0);
+    board.make_null_move();
+    int value = -alpha_beta(info, board, ply + 1, null_depth, -beta,
+                            -beta + 1, false);
+    board.unmake_null_move();
+    if (info.is_stopped) [[unlikely]]
+      return 0;
+
+    if (value >= beta) {
+      // Mates found after passing are not proven
+      if (value >= MATE_THRESHOLD)
+        value = beta;
+      if (depth < search_params.null_move_verification_depth) {
+        perf_counter.increment("AB_null_move_pruned");
+        return value;
+      }
+      const int verified_value = alpha_beta(info, board, ply, null_depth,
+                                            beta - 1, beta, false);
+      if (info.is_stopped) [[unlikely]]
+        return 0;
+      if (verified_value >= beta) {
+        perf_counter.increment("AB_null_move_verified");
+        return value;
+      }
+    }
+  }
+
+  // Futility pruning: so far below alpha that only captures, promotions and
+  // checks might catch up
+  const bool futile =
+      can_prune && depth <= search_params.futility_max_depth &&
+      std::abs(alpha) < MATE_THRESHOLD &&
+      static_eval + search_params.futility_base_margin +
+              search_params.futility_margin * depth <=
+          alpha;
+  const size_t late_move_count =
+      (search_params.late_move_pruning_base + depth * depth) /
+      (improving ? 1 : 2);
+
   const int start_alpha = alpha;
   move_t best_move = 0;
-  const auto legal_moves = get_sorted_legal_moves(board);
+  MovePicker picker(board, entry.best_move, info.history, ply);
+  MoveList quiets_searched;
+  int moves_searched = 0;
+  for (move_t next_move = picker.next(); next_move; next_move = picker.next()) {
+    const bool quiet = !is_tactical(next_move);
+
+    // Late move pruning: with good move ordering, quiet moves this late
+    // almost never raise alpha at shallow depths
+    if (can_prune && quiet && moves_searched > 0 &&
+        depth <= search_params.late_move_pruning_max_depth &&
+        quiets_searched.size() >= late_move_count) {
+      perf_counter.increment("AB_late_move_pruned");
+      continue;
+    }
+
+    const bool gives_check = board.gives_check(next_move);
+    if (futile && quiet && !gives_check && moves_searched > 0) {
+      perf_counter.increment("AB_futility_pruned");
+      continue;
+    }
 
-  int move_num = 0;
-  for (const move_t next_move : legal_moves) {
     board.make_move(next_move);
-    const int value =
-        -alpha_beta(info, board, ply + 1, depth - 1, -beta, -alpha, true);
+
+    int value;
+    if (moves_searched == 0) {
+      value = -alpha_beta(info, board, ply + 1, depth - 1, -beta, -alpha, true);
+    } else {
+      // Late move reductions: quiet moves late in the ordering are first
+      // searched to a reduced depth, and only searched to full depth if they
+      // unexpectedly raise alpha
+      int reduction = 0;
+      if (quiet && !in_check && !gives_check &&
+          depth >= search_params.lmr_min_depth &&
+          moves_searched >= search_params.lmr_min_moves) {
+        reduction =
+            lmr_reductions[std::min(depth, LMR_TABLE_SIZE - 1)]
+                          [std::min(moves_searched, LMR_TABLE_SIZE - 1)] -
+            is_pv + !improving;
+        // Always leave at least one ply to search
+        reduction = std::clamp(reduction, 0, std::max(depth - 2, 0));
+      }
+
+      // Principal variation search: with good move ordering the first move
+      // is the best, so the others are only searched with a null window to
+      // prove that they are worse, and searched again in full if that fails
+      value = -alpha_beta(info, board, ply + 1, depth - 1 - reduction,
+                          -alpha - 1, -alpha, true);
+      if (value > alpha && reduction > 0 && !info.is_stopped) {
+        perf_counter.increment("AB_lmr_research");
+        value = -alpha_beta(info, board, ply + 1, depth - 1, -alpha - 1,
+                            -alpha, true);
+      }
+      if (value > alpha && value < beta && !info.is_stopped) {
+        perf_counter.increment("AB_pvs_research");
+        value =
+            -alpha_beta(info, board, ply + 1, depth - 1, -beta, -alpha, true);
+      }
+    }
     board.unmake_move();
+    moves_searched++;
 
     if (info.is_stopped) [[unlikely]]
       return 0;
 
     if (value >= beta) {
-      perf_counter.increment("AB_cut_beta_move_" + to_string(move_num, 3));
       perf_counter.increment("AB_cut_beta");
-      transposition_table.insert(board, next_move, depth, value, Lower);
+      if (!is_tactical(next_move))
+        info.history.update(board, ply, depth, next_move, quiets_searched);
+      transposition_table.insert(board, next_move, depth, value, Lower,
+                                 static_eval);
       return value;
     }
+    if (!is_tactical(next_move))
+      quiets_searched.push_back(next_move);
     if (value > alpha) {
       alpha = value;
       best_move = next_move;
     }
-    move_num++;
   }
 
   if (alpha > start_alpha) {
     ASSERT(best_move != 0);
     perf_counter.increment("AB_cut_none_improved");
-    transposition_table.insert(board, best_move, depth, alpha, Exact);
+    transposition_table.insert(board, best_move, depth, alpha, Exact,
+                               static_eval);
+  } else {
+    // No move raised alpha, which the null-window searches of PVS expect
+    // most of the time: remember that so re-searches can cut off straight away
+    perf_counter.increment("AB_cut_none_failed_low");
+    transposition_table.insert(board, 0, depth, alpha, Upper, static_eval);
   }
   return alpha;
 }
 
-void iterative_deepening(SearchInfo &info, Board &board) {
-  std::stringstream info_ss;
-  info_ss << "Searching to depth " << info.depth << " for "
-          << info.seconds_to_search << " seconds";
-  UCIProtocol::send_info(info_ss.str());
-  info_ss.str(std::string());
-
-  for (int depth = 1; depth <= info.depth; ++depth) {
-    alpha_beta(info, board, 0, depth, -SCORE_INFINITY, SCORE_INFINITY, true);
+// Reports the result of the iteration to depth just finished to the GUI
+static void send_iteration_info(const SearchInfo &info, const Board &board,
+                                const int depth, const int score) {
+  std::cout << "info ";
+  std::cout << "score " << eval_to_uci_string(score) << " ";
+  std::cout << "depth " << depth << " ";
+  std::cout << "nodes " << info.nodes << " ";
+  std::cout << "nps "
+            << static_cast<int>(info.nodes / seconds_since(info.start_time))
+            << " ";
+  std::cout << "time "
+            << static_cast<int>(1000 * seconds_since(info.start_time)) << " ";
+  std::cout << "hashfull " << transposition_table.hashfull() << " ";
+  std::cout << "pv ";
+  const std::vector<move_t> pv_moves = get_pv(board);
+  for (const move_t move : pv_moves) {
+    std::cout << simple_string_from_move(move) << " ";
+  }
+  std::cout << std::endl;
 
-    if (info.is_stopped) [[unlikely]]
-      break;
+  std::cout << "info string hash " << transposition_table.size_in_mb()
+            << " MB, " << transposition_table.capacity() << " entries, "
+            << transposition_table.hashfull() << " permille full"
+            << std::endl;
+}
 
-    // The rest of the loop body is UCI stuff
-    if (!info.send_info)
-      continue;
+void iterative_deepening(SearchInfo &info, Board &board,
+                         const int start_depth = 1) {
+  if (info.send_info) {
+    std::stringstream info_ss;
+    info_ss << "Searching to depth " << info.depth;
+    if (!info.infinite) {
+      info_ss << " for " << info.time_manager.optimum_seconds() << " to "
+              << info.time_manager.maximum_seconds() << " seconds";
+    }
+    info_ss << " with " << info.num_threads << " threads";
+    UCIProtocol::send_info(info_ss.str());
+  }
 
-    const TableEntry entry = transposition_table.query(board.hash());
-    std::cout << "info ";
-    std::cout << "score " << eval_to_uci_string(entry.value) << " ";
-    std::cout << "depth " << entry.depth << " ";
-    std::cout << "nodes " << info.nodes << " ";
-    std::cout << "nps "
-              << static_cast<int>(info.nodes / seconds_since(info.start_time))
-              << " ";
-    std::cout << "time "
-              << static_cast<int>(1000 * seconds_since(info.start_time)) << " ";
-    std::cout << "pv ";
-    const std::vector<move_t> pv_moves = get_pv(board);
-    for (const move_t move : pv_moves) {
-      std::cout << simple_string_from_move(move) << " ";
+  int score = 0;
+  float last_iteration_end = 0;
+  for (int depth = start_depth; depth <= info.depth; ++depth) {
+    // Aspiration windows: expect the score to stay close to the previous
+    // iteration's, and widen the window on whichever side it falls outside
+    int delta = ASPIRATION_WINDOW;
+    int alpha = -SCORE_INFINITY, beta = SCORE_INFINITY;
+    if (depth >= ASPIRATION_MIN_DEPTH && std::abs(score) < MATE_THRESHOLD) {
+      alpha = std::max(score - delta, (int)-SCORE_INFINITY);
+      beta = std::min(score + delta, (int)SCORE_INFINITY);
+    }
+    while (true) {
+      score = alpha_beta(info, board, 0, depth, alpha, beta, true);
+      if (info.is_stopped) [[unlikely]]
+        break;
+
+      const bool failed_low = score <= alpha, failed_high = score >= beta;
+      if (!failed_low && !failed_high)
+        break;
+      // A score at an infinite bound, such as when already checkmated, can't
+      // be improved on by widening the window
+      if (failed_low ? alpha <= -SCORE_INFINITY : beta >= SCORE_INFINITY)
+        break;
+      if (info.send_info) {
+        std::cout << "info depth " << depth << " score "
+                  << eval_to_uci_string(score)
+                  << (failed_low ? " upperbound" : " lowerbound") << " nodes "
+                  << info.nodes << " time "
+                  << static_cast<int>(1000 * seconds_since(info.start_time))
+                  << std::endl;
+      }
+      delta *= 2;
+      if (failed_low) {
+        beta = (alpha + beta) / 2;
+        alpha = std::max(score - delta, (int)-SCORE_INFINITY);
+      } else {
+        beta = std::min(score + delta, (int)SCORE_INFINITY);
+      }
     }
-    std::cout << std::endl;
 
-    std::cout << "info string entries " << transposition_table.size()
-              << std::endl;
+    if (info.is_stopped) [[unlikely]]
+      break;
+    if (info.send_info)
+      send_iteration_info(info, board, depth, score);
+    // Checkmate or stalemate at the root won't change with more depth
+    if (!board.has_legal_moves())
+      break;
+
+    // Decide whether the next iteration is worth starting
+    const float elapsed = seconds_since(info.start_time);
+    const move_t best_move = transposition_table.query(board.hash()).best_move;
+    if (info.time_manager.iteration_done(best_move, score, elapsed,
+                                         elapsed - last_iteration_end) &&
+        !info.infinite)
+      break;
+    last_iteration_end = elapsed;
   }
 }
 
 move_t search(SearchInfo &info, const Board &board) {
   perf_counter.clear();
-  if (board.m_fifty_move == 0)
-    transposition_table.clear_for_search(board);
+  transposition_table.new_search();
+
+  // Lazy SMP: helper threads search the same position on their own boards and
+  // only communicate with the main thread through the transposition table.
+  // Every other helper starts a ply deeper, so that they don't all search the
+  // same depths in lockstep. The helpers run until the main thread finishes.
+  std::vector<std::unique_ptr<SearchInfo>> helper_infos;
+  std::vector<std::thread> helpers;
+  for (int idx = 1; idx < info.num_threads; ++idx) {
+    helper_infos.push_back(std::make_unique<SearchInfo>(
+        TimeManager(), info.depth, true, false));
+    helpers.emplace_back([&board, &helper_info = *helper_infos.back(), idx] {
+      Board helper_board(board);
+      iterative_deepening(helper_info, helper_board, 1 + idx % 2);
+    });
+  }
 
   Board tmp(board);
   iterative_deepening(info, tmp);
+  for (const auto &helper_info : helper_infos)
+    helper_info->has_quit = true;
+  for (std::thread &helper : helpers)
+    helper.join();
+
+  // Another position's entry may have overwritten the root's, so its move
+  // has to be checked before being played
+  // There is no move to make in checkmate or stalemate, which UCI reports as
+  // the null move 0000
   const TableEntry entry = transposition_table.query(board.hash());
+  const MoveList legal_moves = get_sorted_legal_moves(tmp);
+  move_t best_move = 0;
+  if (board.is_legal(entry.best_move))
+    best_move = entry.best_move;
+  else if (!legal_moves.empty())
+    best_move = legal_moves[0];
 
   if (info.send_info) {
-    const move_t best_move =
-        entry.best_move ? entry.best_move : get_sorted_legal_moves(board)[0];
-    std::cout << "bestmove " << simple_string_from_move(best_move) << std::endl;
+    std::cout << "bestmove "
+              << (best_move ? simple_string_from_move(best_move) : "0000")
+              << std::endl;
   }
-  return entry.best_move;
+  return best_move;
 }
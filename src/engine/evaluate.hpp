@@ -14,6 +14,8 @@ enum {
   SCORE_INFINITY = MATE,
   MAX_MATE_LENGTH = 100,
   MATE_THRESHOLD = MATE - MAX_MATE_LENGTH * MATE_OFFSET,
+  // Marks a missing static evaluation, such as when in check
+  NO_EVAL = -SCORE_INFINITY - 1,
 };
 
 constexpr inline int mate_in(const int num_moves) {
@@ -44,5 +46,9 @@ inline std::string eval_to_uci_string(const int value) {
   return result.str();
 }
 
+// The evaluation of a position which is not checkmate, stalemate or drawn:
+// the search detects those itself before evaluating
 int static_evaluate_board(const Board &board, const int side);
+// Bonuses for piece activity and king safety, from white's perspective
+score_t evaluate_pieces(const Board &board);
 move_t search(SearchInfo &info, const Board &board);
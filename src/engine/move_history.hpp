@@ -0,0 +1,83 @@
+
+#pragma once
+
+#include "board.hpp"
+#include "move.hpp"
+#include "move_list.hpp"
+
+#include <array>
+#include <cstdlib>
+
+// NOTE: The deepest ply at which killer moves are kept
+enum { MAX_SEARCH_PLY = 128 };
+
+// Statistics about which quiet moves caused beta cutoffs, used to order quiet
+// moves in later nodes. Each search thread keeps its own, so they need no
+// synchronization.
+//   - Killers: the last two quiet moves to cause a cutoff at each ply, which
+//     often refute the sibling positions too
+//   - History: a score per [side][from][to], raised by the square of the depth
+//     of each cutoff the move causes, and lowered for the quiet moves searched
+//     before it which did not
+//   - Counter moves: the last quiet move to refute each [piece][to] move
+struct MoveHistory {
+  // History scores saturate at this magnitude: each update moves a score
+  // towards the bound in proportion to how far away it is
+  static constexpr int MAX_HISTORY = 1 << 14;
+
+  std::array<std::array<move_t, 2>, MAX_SEARCH_PLY> killers{};
+  int butterfly[2][64][64]{};
+  move_t counter_moves[16][64]{};
+
+  inline const std::array<move_t, 2> &killers_at(const int ply) const {
+    static constexpr std::array<move_t, 2> no_killers = {};
+    return ply < MAX_SEARCH_PLY ? killers[ply] : no_killers;
+  }
+
+  inline int history_score(const int side, const move_t move) const {
+    return butterfly[side][get_square_64(move_from(move))]
+                    [get_square_64(move_to(move))];
+  }
+
+  // The counter move to the move that led to the board's position, if any
+  inline move_t counter_move(const Board &board) const {
+    if (board.m_history_size == 0)
+      return 0;
+    const move_t last_move = board.history_entry(1).move;
+    if (last_move == NULL_MOVE)
+      return 0;
+    return counter_moves[moved_piece(last_move)]
+                        [get_square_64(move_to(last_move))];
+  }
+
+  // Records that the quiet move caused a beta cutoff in the board's position,
+  // after the (quiet) moves in 'searched' failed to
+  void update(const Board &board, const int ply, const int depth,
+              const move_t move, const MoveList &searched) {
+    if (ply < MAX_SEARCH_PLY && killers[ply][0] != move) {
+      killers[ply][1] = killers[ply][0];
+      killers[ply][0] = move;
+    }
+
+    const int side = board.m_side_to_move;
+    const int bonus = std::min(depth * depth, MAX_HISTORY);
+    update_history(side, move, bonus);
+    for (const move_t other : searched)
+      update_history(side, other, -bonus);
+
+    if (board.m_history_size > 0) {
+      const move_t last_move = board.history_entry(1).move;
+      if (last_move != NULL_MOVE)
+        counter_moves[moved_piece(last_move)]
+                     [get_square_64(move_to(last_move))] = move;
+    }
+  }
+
+private:
+  inline void update_history(const int side, const move_t move,
+                             const int bonus) {
+    int &score = butterfly[side][get_square_64(move_from(move))]
+                          [get_square_64(move_to(move))];
+    score += bonus - score * std::abs(bonus) / MAX_HISTORY;
+  }
+};
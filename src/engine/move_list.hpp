@@ -0,0 +1,78 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+
+#include "assert.hpp"
+#include "types.hpp"
+
+// NOTE: The max number of possible moves in any position.
+// SOURCE: https://www.stmintz.com/ccc/index.php?id=424966 (cites 218)
+enum { MAX_POSITION_MOVES = 256 };
+
+// A move together with a move-ordering score. Converts implicitly to move_t so
+// that a MoveList can be iterated as a list of plain moves.
+struct ScoredMove {
+  move_t move;
+  int score;
+
+  constexpr inline operator move_t() const noexcept { return move; }
+};
+
+// A fixed-capacity list of moves which lives on the stack, so that generating
+// moves never allocates
+class MoveList {
+  std::array<ScoredMove, MAX_POSITION_MOVES> m_moves;
+  size_t m_size = 0;
+
+public:
+  constexpr inline void push_back(const move_t move,
+                                  const int score = 0) noexcept {
+    ASSERT_MSG(m_size < MAX_POSITION_MOVES, "Move list overflowed");
+    m_moves[m_size++] = {move, score};
+  }
+  constexpr inline void clear() noexcept { m_size = 0; }
+  // Drops every move from index 'size' onwards
+  constexpr inline void resize(const size_t size) noexcept {
+    ASSERT(size <= m_size);
+    m_size = size;
+  }
+  constexpr inline size_t size() const noexcept { return m_size; }
+  constexpr inline bool empty() const noexcept { return m_size == 0; }
+
+  constexpr inline ScoredMove &operator[](const size_t idx) noexcept {
+    ASSERT(idx < m_size);
+    return m_moves[idx];
+  }
+  constexpr inline const ScoredMove &
+  operator[](const size_t idx) const noexcept {
+    ASSERT(idx < m_size);
+    return m_moves[idx];
+  }
+
+  constexpr inline ScoredMove *begin() noexcept { return m_moves.data(); }
+  constexpr inline ScoredMove *end() noexcept {
+    return m_moves.data() + m_size;
+  }
+  constexpr inline const ScoredMove *begin() const noexcept {
+    return m_moves.data();
+  }
+  constexpr inline const ScoredMove *end() const noexcept {
+    return m_moves.data() + m_size;
+  }
+
+  constexpr inline bool contains(const move_t move) const noexcept {
+    return std::find_if(begin(), end(), [move](const ScoredMove &entry) {
+             return entry.move == move;
+           }) != end();
+  }
+
+  // Sorts by descending score, breaking ties by the move itself so that the
+  // order is deterministic
+  inline void sort() noexcept {
+    std::sort(begin(), end(), [](const ScoredMove &a, const ScoredMove &b) {
+      return a.score != b.score ? a.score > b.score : a.move > b.move;
+    });
+  }
+};
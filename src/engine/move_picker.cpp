@@ -0,0 +1,198 @@
+
+#include "move_picker.hpp"
+
+#include "perf_counter.hpp"
+#include "piece_values.hpp"
+#include "see.hpp"
+
+#include <algorithm>
+#include <utility>
+
+MovePicker::MovePicker(const Board &board, const move_t tt_move,
+                       const std::array<move_t, 2> &killers,
+                       const bool generate_quiet_moves,
+                       const bool generate_quiet_checks) noexcept
+    : m_board(board), m_tt_move(tt_move),
+      m_refutations({killers[0], killers[1], 0}),
+      m_generate_quiet_moves(generate_quiet_moves),
+      m_generate_quiet_checks(generate_quiet_checks && !generate_quiet_moves) {
+}
+
+MovePicker::MovePicker(const Board &board, const move_t tt_move,
+                       const MoveHistory &history, const int ply) noexcept
+    : m_board(board), m_tt_move(tt_move),
+      m_refutations({history.killers_at(ply)[0], history.killers_at(ply)[1],
+                     history.counter_move(board)}),
+      m_history(&history), m_generate_quiet_moves(true) {}
+
+move_t MovePicker::select_best(MoveList &moves) noexcept {
+  size_t best_idx = m_idx;
+  for (size_t idx = m_idx + 1; idx < moves.size(); ++idx) {
+    if (moves[idx].score > moves[best_idx].score)
+      best_idx = idx;
+  }
+  std::swap(moves[m_idx], moves[best_idx]);
+  return moves[m_idx++].move;
+}
+
+// Captures are ordered by most valuable victim, then least valuable attacker,
+// and promotions by the piece promoted to. Captures which lose material once
+// the exchange is played out wait until after the quiet moves, ordered by how
+// much they lose.
+void MovePicker::score_captures() noexcept {
+  size_t num_good = 0;
+  for (const ScoredMove &scored_move : m_moves) {
+    const move_t move = scored_move.move;
+    if (move == m_tt_move)
+      continue;
+    const int attacker_value = base_piece_values[to_white(moved_piece(move))];
+    int score = 0;
+    if (move_captured(move)) {
+      const int victim_value =
+          base_piece_values[to_white(captured_piece(move))];
+      score += 10 * victim_value + (1000 - attacker_value);
+      // Taking a piece at least as valuable as the attacker can't lose
+      // material, so the exchange only needs playing out otherwise
+      if (victim_value < attacker_value) {
+        const int exchange_value = see(m_board, move);
+        if (exchange_value < 0) {
+          m_bad_captures.push_back(move, exchange_value);
+          continue;
+        }
+      }
+    }
+    if (move_promoted(move))
+      score += 3 * base_piece_values[to_white(promoted_piece(move))];
+    m_moves[num_good++] = {move, score};
+  }
+  m_moves.resize(num_good);
+}
+
+// Quiet moves are ordered by how much they improve the moved piece's square,
+// plus their history scores if there are any. Pieces moving to where an enemy
+// pawn can take them come last.
+void MovePicker::score_quiets() noexcept {
+  const int side = m_board.m_side_to_move;
+  const bitboard_t enemy_pawn_attacks = pawn_attacks_bb(
+      m_board.pieces((side == WHITE) ? BLACK_PAWN : WHITE_PAWN), !side);
+  size_t num_quiets = 0;
+  for (const ScoredMove &scored_move : m_moves) {
+    const move_t move = scored_move.move;
+    if (move == m_tt_move || is_refutation(move))
+      continue;
+    const piece_t piece = moved_piece(move);
+    const int gain = taper(piece_values[piece][move_to(move)] -
+                               piece_values[piece][move_from(move)],
+                           m_board.phase());
+    const int history = m_history ? m_history->history_score(side, move) : 0;
+    int score = ((side == WHITE) ? gain : -gain) + history;
+    if (!is_pawn(piece) && (enemy_pawn_attacks & square_bb_120(move_to(move))))
+      score -= base_piece_values[to_white(piece)];
+    m_moves[num_quiets++] = {move, score};
+  }
+  m_moves.resize(num_quiets);
+}
+
+// Quiet checks are ordered by how much they improve the moved piece's square.
+// The TT move is never among them, since it is only yielded here if tactical.
+void MovePicker::score_quiet_checks() noexcept {
+  const int side = m_board.m_side_to_move;
+  size_t num_checks = 0;
+  for (const ScoredMove &scored_move : m_moves) {
+    const move_t move = scored_move.move;
+    if (!m_board.gives_check(move))
+      continue;
+    const piece_t piece = moved_piece(move);
+    const int gain = taper(piece_values[piece][move_to(move)] -
+                               piece_values[piece][move_from(move)],
+                           m_board.phase());
+    m_moves[num_checks++] = {move, (side == WHITE) ? gain : -gain};
+  }
+  m_moves.resize(num_checks);
+}
+
+move_t MovePicker::next() noexcept {
+  switch (m_stage) {
+  case TT_MOVE:
+    m_stage = GENERATE_CAPTURES;
+    if (m_tt_move && (m_generate_quiet_moves || is_tactical(m_tt_move)) &&
+        m_board.is_legal(m_tt_move)) {
+      perf_counter.increment("MP_tt_move");
+      return m_tt_move;
+    }
+    [[fallthrough]];
+
+  case GENERATE_CAPTURES:
+    m_moves = m_board.legal_moves(TACTICAL_MOVES);
+    score_captures();
+    m_idx = 0;
+    m_stage = GOOD_CAPTURES;
+    [[fallthrough]];
+
+  case GOOD_CAPTURES:
+    if (m_idx < m_moves.size())
+      return select_best(m_moves);
+    if (m_generate_quiet_moves)
+      m_stage = KILLERS;
+    else if (m_generate_quiet_checks)
+      m_stage = GENERATE_QUIET_CHECKS;
+    else
+      m_stage = BAD_CAPTURES;
+    m_idx = 0;
+    return next();
+
+  case GENERATE_QUIET_CHECKS:
+    m_moves = m_board.legal_moves(QUIET_MOVES);
+    score_quiet_checks();
+    m_idx = 0;
+    m_stage = QUIET_CHECKS;
+    [[fallthrough]];
+
+  case QUIET_CHECKS:
+    if (m_idx < m_moves.size())
+      return select_best(m_moves);
+    m_stage = BAD_CAPTURES;
+    m_idx = 0;
+    return next();
+
+  case KILLERS:
+    while (m_idx < m_refutations.size()) {
+      const move_t refutation = m_refutations[m_idx++];
+      // The counter move may also be one of the killers
+      const bool repeated =
+          std::find(m_refutations.begin(), m_refutations.begin() + m_idx - 1,
+                    refutation) != m_refutations.begin() + m_idx - 1;
+      if (refutation && refutation != m_tt_move && !repeated &&
+          !is_tactical(refutation) && m_board.is_legal(refutation)) {
+        perf_counter.increment("MP_refutation");
+        return refutation;
+      }
+    }
+    m_stage = GENERATE_QUIETS;
+    [[fallthrough]];
+
+  case GENERATE_QUIETS:
+    m_moves = m_board.legal_moves(QUIET_MOVES);
+    score_quiets();
+    m_idx = 0;
+    m_stage = QUIETS;
+    [[fallthrough]];
+
+  case QUIETS:
+    if (m_idx < m_moves.size())
+      return select_best(m_moves);
+    m_stage = BAD_CAPTURES;
+    m_idx = 0;
+    [[fallthrough]];
+
+  case BAD_CAPTURES:
+    if (m_idx < m_bad_captures.size())
+      return select_best(m_bad_captures);
+    m_stage = DONE;
+    [[fallthrough]];
+
+  case DONE:
+    return 0;
+  }
+  return 0;
+}
@@ -0,0 +1,85 @@
+
+#pragma once
+
+#include "board.hpp"
+#include "move.hpp"
+#include "move_history.hpp"
+#include "move_list.hpp"
+
+#include <array>
+
+// Yields the legal moves of a position one at a time, in the order the search
+// should try them. Moves are produced in stages, and each stage is generated
+// and scored only once the previous stages are exhausted, since most beta
+// cutoffs happen on the first move or two:
+//   - the transposition table move, checked for legality without generating
+//   - captures and promotions which don't lose material, best first
+//   - killer moves and the counter move, checked for legality without
+//     generating
+//   - the remaining quiet moves, by history score
+//   - the remaining captures, which lose material by static exchange
+// Quiescence search only asks for the captures, and optionally the quiet moves
+// which give check, in place of the killers and quiet moves.
+// Each stage is only partially sorted: the best remaining move is selected
+// when asked for, so moves after a cutoff are never sorted at all.
+class MovePicker {
+public:
+  enum Stage {
+    TT_MOVE,
+    GENERATE_CAPTURES,
+    GOOD_CAPTURES,
+    GENERATE_QUIET_CHECKS,
+    QUIET_CHECKS,
+    KILLERS,
+    GENERATE_QUIETS,
+    QUIETS,
+    BAD_CAPTURES,
+    DONE,
+  };
+
+  // With generate_quiet_moves unset, only captures and promotions are yielded,
+  // as in quiescence search, followed by the quiet checks if
+  // generate_quiet_checks is set
+  MovePicker(const Board &board, const move_t tt_move,
+             const std::array<move_t, 2> &killers = {},
+             const bool generate_quiet_moves = true,
+             const bool generate_quiet_checks = false) noexcept;
+  // Orders quiet moves using the killers at ply, the counter move and history
+  // scores gathered by the search
+  MovePicker(const Board &board, const move_t tt_move,
+             const MoveHistory &history, const int ply) noexcept;
+
+  // The next move to search, or 0 once every move has been yielded
+  move_t next() noexcept;
+  Stage stage() const noexcept { return m_stage; }
+
+private:
+  const Board &m_board;
+  const move_t m_tt_move;
+  // The two killers, then the counter move
+  const std::array<move_t, 3> m_refutations;
+  const MoveHistory *m_history = nullptr;
+  const bool m_generate_quiet_moves;
+  const bool m_generate_quiet_checks = false;
+  Stage m_stage = TT_MOVE;
+
+  MoveList m_moves;        // The captures, then the quiet moves
+  MoveList m_bad_captures; // Set aside while scoring the captures
+  size_t m_idx = 0;        // The next unyielded move of the current stage
+
+  bool is_refutation(const move_t move) const noexcept {
+    return move == m_refutations[0] || move == m_refutations[1] ||
+           move == m_refutations[2];
+  }
+  // Swaps the highest-scored move at or after m_idx into m_idx and returns it
+  move_t select_best(MoveList &moves) noexcept;
+  void score_captures() noexcept;
+  void score_quiets() noexcept;
+  void score_quiet_checks() noexcept;
+};
+
+// Whether a move changes the material on the board, and is therefore searched
+// by quiescence search and yielded with the captures
+constexpr inline bool is_tactical(const move_t move) {
+  return move_captured(move) || move_promoted(move);
+}
@@ -1,4 +1,5 @@
 
+#include "bitboard.hpp"
 #include "board.hpp"
 #include "move.hpp"
 #include "piece.hpp"
@@ -8,19 +9,16 @@
 #include <map>
 #include <set>
 #include <string>
-#include <vector>
 
-std::vector<move_t>
-Board::pseudo_moves(const bool generate_quiet_moves) const noexcept {
+MoveList Board::pseudo_moves(const MoveGenType type) const noexcept {
 
   // In debug mode, check that invariants are maintained
   validate_board();
 
-  std::vector<move_t> result;
+  const bool generate_tactical_moves = type != QUIET_MOVES;
+  const bool generate_quiet_moves = type != TACTICAL_MOVES;
 
-  // Reserve some starting amount of space for moves, this is set to 64, roughly
-  // twice the average branching factor
-  result.reserve(START_POSITION_MOVES);
+  MoveList result;
 
   const int side = m_side_to_move;
   const piece_t king_piece = (side == WHITE) ? WHITE_KING : BLACK_KING,
@@ -37,204 +35,149 @@ Board::pseudo_moves(const bool generate_quiet_moves) const noexcept {
       static_cast<piece_t>(knight_piece ^ 8u),
   };
 
+  const bitboard_t own = m_side_bitboards[side];
+  const bitboard_t enemy = m_side_bitboards[!side];
+  const bitboard_t occ = own | enemy;
+  const bitboard_t empty = ~occ;
+  // Kings are never captured: king-capturing moves are never generated. When
+  // only quiet moves are wanted, there is nothing to capture at all.
+  const bitboard_t capture_targets =
+      enemy & ~(m_bitboards[WHITE_KING] | m_bitboards[BLACK_KING]) &
+      (generate_tactical_moves ? ~EMPTY_BB : 0);
+
+  // Adds a quiet move or capture from 'start' to each square in 'targets'
+  const auto add_piece_moves = [&](const square_t start, const piece_t piece,
+                                   const bitboard_t targets) {
+    bitboard_t captures = targets & capture_targets;
+    while (captures) {
+      const square_t cur_square = get_square_120(pop_lsb(captures));
+      INFO("Capture move from %s to %s", string_from_square(start).c_str(),
+           string_from_square(cur_square).c_str());
+      result.push_back(
+          capture_move(start, cur_square, piece, m_pieces[cur_square]));
+    }
+    if (!generate_quiet_moves)
+      return;
+    bitboard_t quiets = targets & empty;
+    while (quiets) {
+      const square_t cur_square = get_square_120(pop_lsb(quiets));
+      INFO("Quiet move from %s to %s", string_from_square(start).c_str(),
+           string_from_square(cur_square).c_str());
+      result.push_back(quiet_move(start, cur_square, piece));
+    }
+  };
+
   // Queens
   INFO("Generating queen moves");
-  const size_t num_queens = m_num_pieces[queen_piece];
-  for (unsigned queen_idx = 0; queen_idx < num_queens; ++queen_idx) {
-    const square_t start = m_positions[queen_piece][queen_idx];
-    for (const int offset : {-11, -10, -9, -1, 1, 9, 10, 11}) {
-      square_t cur_square = start + offset;
-      while (valid_square(cur_square) &&
-             m_pieces[cur_square] == INVALID_PIECE) {
-        INFO("Quiet move from %s to %s", string_from_square(start).c_str(),
-             string_from_square(cur_square).c_str());
-        if (generate_quiet_moves)
-          result.push_back(quiet_move(start, cur_square, queen_piece));
-        cur_square += offset;
-      }
-      if (valid_square(cur_square) &&
-          opposite_colours(queen_piece, m_pieces[cur_square]) &&
-          !is_king(m_pieces[cur_square])) {
-        INFO("Capture move from %s to %s", string_from_square(start).c_str(),
-             string_from_square(cur_square).c_str());
-        result.push_back(
-            capture_move(start, cur_square, queen_piece, m_pieces[cur_square]));
-      }
-    }
+  bitboard_t queens = m_bitboards[queen_piece];
+  while (queens) {
+    const int start64 = pop_lsb(queens);
+    add_piece_moves(get_square_120(start64), queen_piece,
+                    queen_attacks(start64, occ));
   }
 
   // Rooks
   INFO("Generating rook moves");
-  const size_t num_rooks = m_num_pieces[rook_piece];
-  for (unsigned rook_idx = 0; rook_idx < num_rooks; ++rook_idx) {
-    const square_t start = m_positions[rook_piece][rook_idx];
-    for (const int offset : {-10, -1, 1, 10}) {
-      square_t cur_square = start + offset;
-      while (valid_square(cur_square) &&
-             m_pieces[cur_square] == INVALID_PIECE) {
-        INFO("Quiet move from %s to %s", string_from_square(start).c_str(),
-             string_from_square(cur_square).c_str());
-        if (generate_quiet_moves)
-          result.push_back(quiet_move(start, cur_square, rook_piece));
-        cur_square += offset;
-      }
-      if (valid_square(cur_square) &&
-          opposite_colours(rook_piece, m_pieces[cur_square]) &&
-          !is_king(m_pieces[cur_square])) {
-        INFO("Capture move from %s to %s", string_from_square(start).c_str(),
-             string_from_square(cur_square).c_str());
-        result.push_back(
-            capture_move(start, cur_square, rook_piece, m_pieces[cur_square]));
-      }
-    }
+  bitboard_t rooks = m_bitboards[rook_piece];
+  while (rooks) {
+    const int start64 = pop_lsb(rooks);
+    add_piece_moves(get_square_120(start64), rook_piece,
+                    rook_attacks(start64, occ));
   }
 
   // Bishops
   INFO("Generating bishop moves");
-  const size_t num_bishops = m_num_pieces[bishop_piece];
-  for (unsigned bishop_idx = 0; bishop_idx < num_bishops; ++bishop_idx) {
-    const square_t start = m_positions[bishop_piece][bishop_idx];
-    for (const int offset : {-11, -9, 9, 11}) {
-      square_t cur_square = start + offset;
-      while (valid_square(cur_square) &&
-             m_pieces[cur_square] == INVALID_PIECE) {
-        INFO("Quiet move from %s to %s", string_from_square(start).c_str(),
-             string_from_square(cur_square).c_str());
-        if (generate_quiet_moves)
-          result.push_back(quiet_move(start, cur_square, bishop_piece));
-        cur_square += offset;
-      }
-      if (valid_square(cur_square) &&
-          opposite_colours(bishop_piece, m_pieces[cur_square]) &&
-          !is_king(m_pieces[cur_square])) {
-        INFO("Capture move from %s to %s", string_from_square(start).c_str(),
-             string_from_square(cur_square).c_str());
-        result.push_back(capture_move(start, cur_square, bishop_piece,
-                                      m_pieces[cur_square]));
-      }
-    }
+  bitboard_t bishops = m_bitboards[bishop_piece];
+  while (bishops) {
+    const int start64 = pop_lsb(bishops);
+    add_piece_moves(get_square_120(start64), bishop_piece,
+                    bishop_attacks(start64, occ));
   }
 
   // Knights
   INFO("Generating knight moves");
-  const size_t num_knights = m_num_pieces[knight_piece];
-  for (unsigned knight_idx = 0; knight_idx < num_knights; ++knight_idx) {
-    const square_t start = m_positions[knight_piece][knight_idx];
-    for (const int offset : {-21, -19, -12, -8, 8, 12, 19, 21}) {
-      const square_t cur_square = start + offset;
-      if (!valid_square(cur_square))
-        continue;
-      if (m_pieces[cur_square] == INVALID_PIECE) {
-        if (generate_quiet_moves)
-          result.push_back(quiet_move(start, cur_square, knight_piece));
-      } else if (opposite_colours(knight_piece, m_pieces[cur_square]) &&
-                 !is_king(m_pieces[cur_square])) {
-        result.push_back(capture_move(start, cur_square, knight_piece,
-                                      m_pieces[cur_square]));
-      }
-    }
+  bitboard_t knights = m_bitboards[knight_piece];
+  while (knights) {
+    const int start64 = pop_lsb(knights);
+    add_piece_moves(get_square_120(start64), knight_piece,
+                    knight_attacks[start64]);
   }
 
   // Pawns
   INFO("Generating pawn moves");
-  const size_t num_pawns = m_num_pieces[pawn_piece];
-  for (unsigned pawn_idx = 0; pawn_idx < num_pawns; ++pawn_idx) {
-    const square_t start = m_positions[pawn_piece][pawn_idx];
-    const int offset = (side == WHITE) ? 10 : -10;
-    const square_t cur_square = start + offset;
-
-    // Double pawn moves
-    if (generate_quiet_moves) {
-      if (side == WHITE && get_square_row(start) == RANK_2 &&
-          m_pieces[start + 10] == INVALID_PIECE &&
-          m_pieces[start + 20] == INVALID_PIECE) {
-        result.push_back(double_move(start, start + 20, pawn_piece));
-      }
-      if (side == BLACK && get_square_row(start) == RANK_7 &&
-          m_pieces[start - 10] == INVALID_PIECE &&
-          m_pieces[start - 20] == INVALID_PIECE) {
-        result.push_back(double_move(start, start - 20, pawn_piece));
-      }
-    }
+  const bitboard_t pawns = m_bitboards[pawn_piece];
+  const int pawn_offset = (side == WHITE) ? 10 : -10;
+  const bitboard_t promotion_rank = (side == WHITE) ? RANK_8_BB : RANK_1_BB;
+  const bitboard_t single_pushes =
+      ((side == WHITE) ? shift_north(pawns) : shift_south(pawns)) & empty;
 
-    // Single pawn moves
-    if (valid_square(cur_square) && m_pieces[cur_square] == INVALID_PIECE) {
-      if (get_square_row(cur_square) == RANK_1 ||
-          get_square_row(cur_square) == RANK_8) {
-        for (const piece_t promote_piece : promote_pieces) {
-          result.push_back(
-              promote_move(start, cur_square, pawn_piece, promote_piece));
-        }
-      } else {
-        if (generate_quiet_moves)
-          result.push_back(quiet_move(start, start + offset, pawn_piece));
-      }
+  // Single pawn moves, of which those to the last rank are promotions
+  bitboard_t promotions = single_pushes & promotion_rank &
+                          (generate_tactical_moves ? ~EMPTY_BB : 0);
+  while (promotions) {
+    const square_t cur_square = get_square_120(pop_lsb(promotions));
+    for (const piece_t promote_piece : promote_pieces) {
+      result.push_back(promote_move(cur_square - pawn_offset, cur_square,
+                                    pawn_piece, promote_piece));
+    }
+  }
+  if (generate_quiet_moves) {
+    bitboard_t pushes = single_pushes & ~promotion_rank;
+    while (pushes) {
+      const square_t cur_square = get_square_120(pop_lsb(pushes));
+      result.push_back(
+          quiet_move(cur_square - pawn_offset, cur_square, pawn_piece));
     }
 
-    // Normal capture moves
-    INFO("Generating pawn capture moves");
-    const square_t capture1 = cur_square - 1, capture2 = cur_square + 1;
-    if (valid_square(capture1) && m_pieces[capture1] != INVALID_PIECE &&
-        opposite_colours(pawn_piece, m_pieces[capture1]) &&
-        !is_king(m_pieces[capture1])) {
-      if (get_square_row(capture1) == RANK_1 ||
-          get_square_row(capture1) == RANK_8) {
-        for (const piece_t promote_piece : promote_pieces) {
-          result.push_back(promote_capture_move(
-              start, capture1, pawn_piece, promote_piece, m_pieces[capture1]));
-        }
-      } else {
-        result.push_back(
-            capture_move(start, capture1, pawn_piece, m_pieces[capture1]));
-      }
+    // Double pawn moves: pawns which could push once onto the third rank
+    bitboard_t double_pushes =
+        (side == WHITE) ? shift_north(single_pushes & RANK_3_BB) & empty
+                        : shift_south(single_pushes & RANK_6_BB) & empty;
+    while (double_pushes) {
+      const square_t cur_square = get_square_120(pop_lsb(double_pushes));
+      result.push_back(double_move(cur_square - 2 * pawn_offset, cur_square,
+                                   pawn_piece));
     }
-    if (valid_square(capture2) && m_pieces[capture2] != INVALID_PIECE &&
-        opposite_colours(pawn_piece, m_pieces[capture2]) &&
-        !is_king(m_pieces[capture2])) {
-      if (get_square_row(capture2) == RANK_1 ||
-          get_square_row(capture2) == RANK_8) {
+  }
+
+  // Normal capture moves
+  INFO("Generating pawn capture moves");
+  bitboard_t capturing_pawns = pawns;
+  while (capturing_pawns) {
+    const int start64 = pop_lsb(capturing_pawns);
+    const square_t start = get_square_120(start64);
+    bitboard_t captures = pawn_attacks[side][start64] & capture_targets;
+    while (captures) {
+      const int capture64 = pop_lsb(captures);
+      const square_t capture = get_square_120(capture64);
+      if (square_bb(capture64) & promotion_rank) {
         for (const piece_t promote_piece : promote_pieces) {
           result.push_back(promote_capture_move(
-              start, capture2, pawn_piece, promote_piece, m_pieces[capture2]));
+              start, capture, pawn_piece, promote_piece, m_pieces[capture]));
         }
       } else {
         result.push_back(
-            capture_move(start, capture2, pawn_piece, m_pieces[capture2]));
+            capture_move(start, capture, pawn_piece, m_pieces[capture]));
       }
     }
   }
 
   // En-passant capture
-  if (m_en_passant != INVALID_SQUARE) {
-    const int offset = (side == WHITE) ? 10 : -10;
-    const square_t start1 = m_en_passant + 1 - offset;
-    const square_t start2 = m_en_passant - 1 - offset;
-    // 'start1' and 'start2' are the two possible starting squares for an
-    // en-passant capture: we don't have to check that they are valid since
-    // invalid squares will always have invalid pieces
-    if (m_pieces[start1] == pawn_piece) {
-      result.push_back(en_passant_move(start1, m_en_passant, pawn_piece));
-    }
-    if (m_pieces[start2] == pawn_piece) {
-      result.push_back(en_passant_move(start2, m_en_passant, pawn_piece));
+  if (generate_tactical_moves && m_en_passant != INVALID_SQUARE) {
+    // The pawns which could capture onto the en-passant square are exactly
+    // those attacked by an enemy pawn standing on it
+    bitboard_t attackers =
+        pawn_attacks[!side][get_square_64(m_en_passant)] & pawns;
+    while (attackers) {
+      const square_t start = get_square_120(pop_lsb(attackers));
+      result.push_back(en_passant_move(start, m_en_passant, pawn_piece));
     }
   }
 
   // King
   INFO("Generating king moves");
   const square_t start = m_positions[king_piece][0];
-  for (const int offset : {-11, -10, -9, -1, 1, 9, 10, 11}) {
-    const square_t cur_square = start + offset;
-    const piece_t piece = m_pieces[cur_square];
-    if (!valid_square(cur_square))
-      continue;
-    if (piece == INVALID_PIECE) {
-      if (generate_quiet_moves)
-        result.push_back(quiet_move(start, cur_square, king_piece));
-    } else if (opposite_colours(king_piece, piece) && !is_king(piece)) {
-      result.push_back(capture_move(start, cur_square, king_piece, piece));
-    }
-  }
+  add_piece_moves(start, king_piece, king_attacks[get_square_64(start)]);
 
   // Castling
   INFO("Generating castling moves");
@@ -272,31 +215,494 @@ Board::pseudo_moves(const bool generate_quiet_moves) const noexcept {
   return result;
 }
 
+// The pieces of the side to move which stand alone between their king and an
+// enemy slider, and so may only move along that line
+bitboard_t Board::pinned_pieces(const int king64) const noexcept {
+  const int side = m_side_to_move;
+  const piece_t offset = (!side) << 3;
+  const bitboard_t enemy = m_side_bitboards[!side];
+  const bitboard_t occ = enemy | m_side_bitboards[side];
+  const bitboard_t enemy_queens = m_bitboards[WHITE_QUEEN | offset];
+  bitboard_t snipers =
+      (rook_attacks(king64, enemy) &
+       (m_bitboards[WHITE_ROOK | offset] | enemy_queens)) |
+      (bishop_attacks(king64, enemy) &
+       (m_bitboards[WHITE_BISHOP | offset] | enemy_queens));
+  bitboard_t result = 0;
+  while (snipers) {
+    const bitboard_t blockers = between_bb[king64][pop_lsb(snipers)] & occ;
+    if (popcount(blockers) == 1)
+      result |= blockers & m_side_bitboards[side];
+  }
+  return result;
+}
+
 bool Board::has_legal_moves() const noexcept {
-  Board tmp(*this);
-  const auto pseudo_moves = this->pseudo_moves();
-  for (const move_t move : pseudo_moves) {
-    if (tmp.make_move(move))
+  if (m_has_legal_moves_hash != m_hash) {
+    m_has_legal_moves = compute_has_legal_moves();
+    m_has_legal_moves_hash = m_hash;
+  }
+  ASSERT(m_has_legal_moves == !legal_moves().empty());
+  return m_has_legal_moves;
+}
+
+// Looks for any single legal move, using the same masks as legal_moves but
+// without building a move list. King moves are tried first since they are the
+// most likely to exist when the answer matters, i.e. in check.
+bool Board::compute_has_legal_moves() const noexcept {
+  const int side = m_side_to_move;
+  const piece_t offset = side << 3;
+  const bitboard_t own = m_side_bitboards[side];
+  const bitboard_t occ = own | m_side_bitboards[!side];
+  const bitboard_t empty = ~occ;
+  const bitboard_t targets =
+      ~own & ~(m_bitboards[WHITE_KING] | m_bitboards[BLACK_KING]);
+
+  const int king64 = get_square_64(m_positions[WHITE_KING | offset][0]);
+  bitboard_t king_targets = king_attacks[king64] & targets;
+  const bitboard_t occ_without_king = occ ^ square_bb(king64);
+  while (king_targets) {
+    if (!attackers_to(pop_lsb(king_targets), !side, occ_without_king))
       return true;
-    tmp.unmake_move();
+  }
+
+  // Castling is not tried: whenever it is legal, so is the king's step
+  // towards the rook
+  const bitboard_t checkers = attackers_to(king64, !side, occ);
+  if (popcount(checkers) > 1)
+    return false;
+  const bitboard_t check_mask =
+      targets &
+      (checkers ? checkers | between_bb[king64][lsb(checkers)] : ~EMPTY_BB);
+  const bitboard_t pinned = pinned_pieces(king64);
+
+  bitboard_t knights = m_bitboards[WHITE_KNIGHT | offset] & ~pinned;
+  while (knights) {
+    if (knight_attacks[pop_lsb(knights)] & check_mask)
+      return true;
+  }
+
+  // Pawns: pushes, then captures, then en-passant
+  const bitboard_t pawns = m_bitboards[WHITE_PAWN | offset];
+  const bitboard_t pushers = pawns & (~pinned | (FILE_A_BB << (king64 % 8)));
+  const bitboard_t single_pushes =
+      ((side == WHITE) ? shift_north(pushers) : shift_south(pushers)) & empty;
+  const bitboard_t double_pushes =
+      ((side == WHITE) ? shift_north(single_pushes & RANK_3_BB)
+                       : shift_south(single_pushes & RANK_6_BB)) &
+      empty;
+  if ((single_pushes | double_pushes) & check_mask)
+    return true;
+
+  const bitboard_t enemy_targets = m_side_bitboards[!side] & check_mask;
+  bitboard_t capturing_pawns = pawns;
+  while (capturing_pawns) {
+    const int start64 = pop_lsb(capturing_pawns);
+    bitboard_t captures = pawn_attacks[side][start64] & enemy_targets;
+    if ((pinned & square_bb(start64)) && captures)
+      captures &= line_bb[king64][start64];
+    if (captures)
+      return true;
+  }
+
+  // Sliders
+  const bitboard_t queens = m_bitboards[WHITE_QUEEN | offset];
+  bitboard_t diagonals = m_bitboards[WHITE_BISHOP | offset] | queens;
+  while (diagonals) {
+    const int start64 = pop_lsb(diagonals);
+    bitboard_t moves = bishop_attacks(start64, occ) & check_mask;
+    if ((pinned & square_bb(start64)) && moves)
+      moves &= line_bb[king64][start64];
+    if (moves)
+      return true;
+  }
+  bitboard_t orthogonals = m_bitboards[WHITE_ROOK | offset] | queens;
+  while (orthogonals) {
+    const int start64 = pop_lsb(orthogonals);
+    bitboard_t moves = rook_attacks(start64, occ) & check_mask;
+    if ((pinned & square_bb(start64)) && moves)
+      moves &= line_bb[king64][start64];
+    if (moves)
+      return true;
+  }
+
+  if (m_en_passant != INVALID_SQUARE) {
+    const int ep64 = get_square_64(m_en_passant);
+    const int pawn_offset = (side == WHITE) ? 10 : -10;
+    const bitboard_t captured_bb = square_bb_120(m_en_passant - pawn_offset);
+    bitboard_t attackers = pawn_attacks[!side][ep64] & pawns;
+    while (attackers) {
+      const bitboard_t after =
+          occ ^ square_bb(pop_lsb(attackers)) ^ square_bb(ep64) ^ captured_bb;
+      if (!(attackers_to(king64, !side, after) & ~captured_bb))
+        return true;
+    }
   }
   return false;
 }
 
-std::vector<move_t>
-Board::legal_moves(const bool generate_quiet_moves) const noexcept {
-  std::vector<move_t> result;
-  Board tmp = *this;
-  const auto pseudo_moves = this->pseudo_moves(generate_quiet_moves);
-  for (const move_t move : pseudo_moves) {
-    if (tmp.make_move(move))
-      result.push_back(move);
-    tmp.unmake_move();
+// Generates only legal moves, without making any of them. The king's checkers
+// restrict every other piece to capturing the checker or blocking its ray, and
+// a piece pinned to its king may only move along the pin line. King moves are
+// tested with the king removed from the occupancy, so that it cannot step back
+// along a slider's ray. En-passant, which removes two pieces from a rank, is
+// checked by recomputing the king's attackers after the capture.
+MoveList Board::legal_moves(const MoveGenType type) const noexcept {
+
+  // In debug mode, check that invariants are maintained
+  validate_board();
+
+  const bool generate_tactical_moves = type != QUIET_MOVES;
+  const bool generate_quiet_moves = type != TACTICAL_MOVES;
+
+  MoveList result;
+
+  const int side = m_side_to_move;
+  const piece_t king_piece = (side == WHITE) ? WHITE_KING : BLACK_KING,
+                queen_piece = (side == WHITE) ? WHITE_QUEEN : BLACK_QUEEN,
+                rook_piece = (side == WHITE) ? WHITE_ROOK : BLACK_ROOK,
+                bishop_piece = (side == WHITE) ? WHITE_BISHOP : BLACK_BISHOP,
+                knight_piece = (side == WHITE) ? WHITE_KNIGHT : BLACK_KNIGHT,
+                pawn_piece = (side == WHITE) ? WHITE_PAWN : BLACK_PAWN;
+
+  const piece_t promote_pieces[4] = {
+      static_cast<piece_t>(queen_piece ^ 8u),
+      static_cast<piece_t>(rook_piece ^ 8u),
+      static_cast<piece_t>(bishop_piece ^ 8u),
+      static_cast<piece_t>(knight_piece ^ 8u),
+  };
+
+  const bitboard_t own = m_side_bitboards[side];
+  const bitboard_t enemy = m_side_bitboards[!side];
+  const bitboard_t occ = own | enemy;
+  const bitboard_t empty = ~occ;
+  // When only quiet moves are wanted, there is nothing to capture
+  const bitboard_t capture_targets =
+      enemy & ~(m_bitboards[WHITE_KING] | m_bitboards[BLACK_KING]) &
+      (generate_tactical_moves ? ~EMPTY_BB : 0);
+
+  const square_t king_square = m_positions[king_piece][0];
+  const int king64 = get_square_64(king_square);
+  const bitboard_t checkers = attackers_to(king64, !side, occ);
+
+  // Adds a quiet move or capture from 'start' to each square in 'targets'
+  const auto add_piece_moves = [&](const square_t start, const piece_t piece,
+                                   const bitboard_t targets) {
+    bitboard_t captures = targets & capture_targets;
+    while (captures) {
+      const square_t cur_square = get_square_120(pop_lsb(captures));
+      result.push_back(
+          capture_move(start, cur_square, piece, m_pieces[cur_square]));
+    }
+    if (!generate_quiet_moves)
+      return;
+    bitboard_t quiets = targets & empty;
+    while (quiets) {
+      const square_t cur_square = get_square_120(pop_lsb(quiets));
+      result.push_back(quiet_move(start, cur_square, piece));
+    }
+  };
+
+  // King
+  bitboard_t king_targets =
+      king_attacks[king64] & (generate_quiet_moves ? ~own : capture_targets);
+  const bitboard_t occ_without_king = occ ^ square_bb(king64);
+  while (king_targets) {
+    const int target64 = pop_lsb(king_targets);
+    if (!attackers_to(target64, !side, occ_without_king))
+      add_piece_moves(king_square, king_piece, square_bb(target64));
+  }
+
+  // In double check, only the king can move
+  if (popcount(checkers) > 1)
+    return result;
+
+  // When in check, every other move must capture the checker or block it
+  const bitboard_t check_mask =
+      checkers ? checkers | between_bb[king64][lsb(checkers)] : ~EMPTY_BB;
+
+  const bitboard_t pinned = pinned_pieces(king64);
+
+  // The squares the piece on start64 may move to without exposing the king
+  const auto legal_mask = [&](const int start64) {
+    return (pinned & square_bb(start64)) ? check_mask & line_bb[king64][start64]
+                                         : check_mask;
+  };
+
+  // Sliders and knights
+  const auto add_slider_moves = [&](const piece_t piece, const auto attacks) {
+    bitboard_t pieces = m_bitboards[piece];
+    while (pieces) {
+      const int start64 = pop_lsb(pieces);
+      add_piece_moves(get_square_120(start64), piece,
+                      attacks(start64) & legal_mask(start64));
+    }
+  };
+  add_slider_moves(queen_piece,
+                   [occ](const int sq64) { return queen_attacks(sq64, occ); });
+  add_slider_moves(rook_piece,
+                   [occ](const int sq64) { return rook_attacks(sq64, occ); });
+  add_slider_moves(bishop_piece,
+                   [occ](const int sq64) { return bishop_attacks(sq64, occ); });
+  // A pinned knight can never stay on its pin line, so skip them outright
+  bitboard_t knights = m_bitboards[knight_piece] & ~pinned;
+  while (knights) {
+    const int start64 = pop_lsb(knights);
+    add_piece_moves(get_square_120(start64), knight_piece,
+                    knight_attacks[start64] & check_mask);
+  }
+
+  // Pawns
+  const bitboard_t pawns = m_bitboards[pawn_piece];
+  const int pawn_offset = (side == WHITE) ? 10 : -10;
+  const bitboard_t promotion_rank = (side == WHITE) ? RANK_8_BB : RANK_1_BB;
+  // Pinned pawns may only push when pinned along the king's file
+  const bitboard_t pushers =
+      pawns & (~pinned | (FILE_A_BB << (king64 % 8)));
+  const bitboard_t single_pushes =
+      ((side == WHITE) ? shift_north(pushers) : shift_south(pushers)) & empty;
+
+  bitboard_t promotions = single_pushes & promotion_rank & check_mask &
+                          (generate_tactical_moves ? ~EMPTY_BB : 0);
+  while (promotions) {
+    const square_t cur_square = get_square_120(pop_lsb(promotions));
+    for (const piece_t promote_piece : promote_pieces) {
+      result.push_back(promote_move(cur_square - pawn_offset, cur_square,
+                                    pawn_piece, promote_piece));
+    }
   }
+  if (generate_quiet_moves) {
+    bitboard_t pushes = single_pushes & ~promotion_rank & check_mask;
+    while (pushes) {
+      const square_t cur_square = get_square_120(pop_lsb(pushes));
+      result.push_back(
+          quiet_move(cur_square - pawn_offset, cur_square, pawn_piece));
+    }
+
+    bitboard_t double_pushes =
+        ((side == WHITE) ? shift_north(single_pushes & RANK_3_BB)
+                         : shift_south(single_pushes & RANK_6_BB)) &
+        empty & check_mask;
+    while (double_pushes) {
+      const square_t cur_square = get_square_120(pop_lsb(double_pushes));
+      result.push_back(double_move(cur_square - 2 * pawn_offset, cur_square,
+                                   pawn_piece));
+    }
+  }
+
+  bitboard_t capturing_pawns = pawns;
+  while (capturing_pawns) {
+    const int start64 = pop_lsb(capturing_pawns);
+    const square_t start = get_square_120(start64);
+    bitboard_t captures =
+        pawn_attacks[side][start64] & capture_targets & legal_mask(start64);
+    while (captures) {
+      const int capture64 = pop_lsb(captures);
+      const square_t capture = get_square_120(capture64);
+      if (square_bb(capture64) & promotion_rank) {
+        for (const piece_t promote_piece : promote_pieces) {
+          result.push_back(promote_capture_move(
+              start, capture, pawn_piece, promote_piece, m_pieces[capture]));
+        }
+      } else {
+        result.push_back(
+            capture_move(start, capture, pawn_piece, m_pieces[capture]));
+      }
+    }
+  }
+
+  // En-passant captures are rare enough to verify directly: lift both pawns,
+  // drop ours on the en-passant square, and look for attackers on the king
+  if (generate_tactical_moves && m_en_passant != INVALID_SQUARE) {
+    const int ep64 = get_square_64(m_en_passant);
+    const bitboard_t captured_bb = square_bb_120(m_en_passant - pawn_offset);
+    bitboard_t attackers = pawn_attacks[!side][ep64] & pawns;
+    while (attackers) {
+      const int start64 = pop_lsb(attackers);
+      const bitboard_t after =
+          occ ^ square_bb(start64) ^ square_bb(ep64) ^ captured_bb;
+      if (!(attackers_to(king64, !side, after) & ~captured_bb)) {
+        result.push_back(en_passant_move(get_square_120(start64), m_en_passant,
+                                         pawn_piece));
+      }
+    }
+  }
+
+  // Castling: the king may not start on, pass through or land on an attacked
+  // square
+  if (generate_quiet_moves && !checkers) {
+    if (side == WHITE && (m_castle_state & WHITE_CASTLE)) {
+      if (m_castle_state & WHITE_SHORT && m_pieces[F1] == INVALID_PIECE &&
+          m_pieces[G1] == INVALID_PIECE && m_pieces[H1] == WHITE_ROOK &&
+          !square_attacked(F1, BLACK) && !square_attacked(G1, BLACK)) {
+        result.push_back(castle_move(E1, G1, WHITE_KING, SHORT_CASTLE_MOVE));
+      }
+      if (m_castle_state & WHITE_LONG && m_pieces[D1] == INVALID_PIECE &&
+          m_pieces[C1] == INVALID_PIECE && m_pieces[B1] == INVALID_PIECE &&
+          m_pieces[A1] == WHITE_ROOK && !square_attacked(D1, BLACK) &&
+          !square_attacked(C1, BLACK)) {
+        result.push_back(castle_move(E1, C1, WHITE_KING, LONG_CASTLE_MOVE));
+      }
+    } else if (side == BLACK && (m_castle_state & BLACK_CASTLE)) {
+      if (m_castle_state & BLACK_SHORT && m_pieces[F8] == INVALID_PIECE &&
+          m_pieces[G8] == INVALID_PIECE && m_pieces[H8] == BLACK_ROOK &&
+          !square_attacked(F8, WHITE) && !square_attacked(G8, WHITE)) {
+        result.push_back(castle_move(E8, G8, BLACK_KING, SHORT_CASTLE_MOVE));
+      }
+      if (m_castle_state & BLACK_LONG && m_pieces[D8] == INVALID_PIECE &&
+          m_pieces[C8] == INVALID_PIECE && m_pieces[B8] == INVALID_PIECE &&
+          m_pieces[A8] == BLACK_ROOK && !square_attacked(D8, WHITE) &&
+          !square_attacked(C8, WHITE)) {
+        result.push_back(castle_move(E8, C8, BLACK_KING, LONG_CASTLE_MOVE));
+      }
+    }
+  }
+
+  ASSERT(result.size() <= MAX_POSITION_MOVES);
   return result;
 }
 
-void print_simple_move_list(const std::vector<move_t> &move_list) {
+// Checks that the move's pieces are where it claims, that the moving piece can
+// reach the target, and that the king is not attacked once the move is made,
+// exactly as in legal_moves. Castling and en-passant are rare enough here to
+// defer to the generator.
+bool Board::is_legal(const move_t move) const noexcept {
+  if (move == 0 || move == NULL_MOVE)
+    return false;
+  const square_t from = move_from(move), to = move_to(move);
+  if (from >= 120 || to >= 120 || !valid_square(from) || !valid_square(to))
+    return false;
+  const int side = m_side_to_move;
+  const piece_t piece = moved_piece(move);
+  if (!valid_piece(piece) || m_pieces[from] != piece || get_side(piece) != side)
+    return false;
+
+  const MoveFlag flag = move_flag(move);
+  if (move_castled(move) || flag == EN_PASSANT_MOVE)
+    return legal_moves().contains(move);
+
+  const piece_t captured = move_captured(move) ? captured_piece(move)
+                                               : (piece_t)INVALID_PIECE;
+  if (m_pieces[to] != captured)
+    return false;
+  if (captured != INVALID_PIECE &&
+      (!valid_piece(captured) || get_side(captured) == side ||
+       is_king(captured)))
+    return false;
+
+  const int from64 = get_square_64(from), to64 = get_square_64(to);
+  const bitboard_t occ = occupied();
+  if (is_pawn(piece)) {
+    const int pawn_offset = (side == WHITE) ? 10 : -10;
+    const bitboard_t promotion_rank = (side == WHITE) ? RANK_8_BB : RANK_1_BB;
+    if (move_promoted(move) != ((square_bb(to64) & promotion_rank) != 0))
+      return false;
+    if (move_captured(move)) {
+      if (!(pawn_attacks[side][from64] & square_bb(to64)))
+        return false;
+    } else if (flag == DOUBLE_PAWN_MOVE) {
+      const bitboard_t start_rank = (side == WHITE) ? RANK_2_BB : RANK_7_BB;
+      if (!(square_bb(from64) & start_rank) || to != from + 2 * pawn_offset ||
+          m_pieces[from + pawn_offset] != INVALID_PIECE)
+        return false;
+    } else if (to != from + pawn_offset) {
+      return false;
+    }
+  } else {
+    if (flag != QUIET_MOVE && flag != CAPTURE_MOVE)
+      return false;
+    bitboard_t attacks = EMPTY_BB;
+    switch (to_white(piece)) {
+    case WHITE_QUEEN:
+      attacks = queen_attacks(from64, occ);
+      break;
+    case WHITE_ROOK:
+      attacks = rook_attacks(from64, occ);
+      break;
+    case WHITE_BISHOP:
+      attacks = bishop_attacks(from64, occ);
+      break;
+    case WHITE_KNIGHT:
+      attacks = knight_attacks[from64];
+      break;
+    case WHITE_KING:
+      attacks = king_attacks[from64];
+      break;
+    }
+    if (!(attacks & square_bb(to64)))
+      return false;
+  }
+
+  // A captured piece no longer attacks anything, and sliders see the board
+  // with the moving piece lifted and dropped on its target
+  const piece_t king_piece = (side == WHITE) ? WHITE_KING : BLACK_KING;
+  const int king64 =
+      is_king(piece) ? to64 : get_square_64(m_positions[king_piece][0]);
+  const bitboard_t after = (occ ^ square_bb(from64)) | square_bb(to64);
+  return !(attackers_to(king64, !side, after) & ~square_bb(to64));
+}
+
+bool Board::gives_check(const move_t move) const noexcept {
+  const int side = m_side_to_move;
+  const piece_t enemy_king = (side == WHITE) ? BLACK_KING : WHITE_KING;
+  const int king64 = get_square_64(m_positions[enemy_king][0]);
+  const square_t from = move_from(move), to = move_to(move);
+  const int from64 = get_square_64(from), to64 = get_square_64(to);
+  const piece_t piece =
+      move_promoted(move) ? promoted_piece(move) : moved_piece(move);
+  ASSERT(get_side(moved_piece(move)) == side);
+
+  // Direct checks by pawns and knights are a table lookup from the target
+  if (is_pawn(piece) && (pawn_attacks[side][to64] & square_bb(king64)))
+    return true;
+  if (to_white(piece) == WHITE_KNIGHT &&
+      (knight_attacks[to64] & square_bb(king64)))
+    return true;
+  return gives_slider_check(move, king64, from64, to64, piece);
+}
+
+bool Board::gives_slider_check(const move_t move, const int king64,
+                               const int from64, const int to64,
+                               const piece_t piece) const noexcept {
+  // A slider can only check the king from one of the king's lines, and a
+  // discovered check needs the moved piece to leave one. Castling and en
+  // passant move or remove a second piece, so always need looking at.
+  const MoveFlag flag = move_flag(move);
+  const bool special = move_castled(move) || flag == EN_PASSANT_MOVE;
+  const bool lands_on_line = (is_diag(piece) || is_ortho(piece)) &&
+                             line_bb[king64][to64] != EMPTY_BB;
+  if (!special && !lands_on_line && line_bb[king64][from64] == EMPTY_BB)
+    return false;
+
+  // Look from the king at the board after the move, for our sliders
+  const int side = m_side_to_move;
+  const piece_t offset = side << 3;
+  const bitboard_t queens = m_bitboards[WHITE_QUEEN | offset];
+  bitboard_t occ = (occupied() ^ square_bb(from64)) | square_bb(to64);
+  bitboard_t diagonals =
+      (m_bitboards[WHITE_BISHOP | offset] | queens) & ~square_bb(from64);
+  bitboard_t orthogonals =
+      (m_bitboards[WHITE_ROOK | offset] | queens) & ~square_bb(from64);
+  if (is_diag(piece))
+    diagonals |= square_bb(to64);
+  if (is_ortho(piece))
+    orthogonals |= square_bb(to64);
+
+  if (flag == EN_PASSANT_MOVE) {
+    occ ^= square_bb(side == WHITE ? to64 - 8 : to64 + 8);
+  } else if (move_castled(move)) {
+    // The rook moves from the corner to the other side of the king
+    const bool is_short = flag == SHORT_CASTLE_MOVE;
+    const bitboard_t rook_move = square_bb(is_short ? from64 + 3 : from64 - 4) |
+                                 square_bb(is_short ? from64 + 1 : from64 - 1);
+    occ ^= rook_move;
+    orthogonals ^= rook_move;
+  }
+  return (bishop_attacks(king64, occ) & diagonals) ||
+         (rook_attacks(king64, occ) & orthogonals);
+}
+
+void print_simple_move_list(const MoveList &move_list) {
   std::set<std::string> moves;
   for (const move_t move : move_list)
     moves.insert(simple_string_from_move(move));
@@ -305,7 +711,7 @@ void print_simple_move_list(const std::vector<move_t> &move_list) {
   std::cout << std::endl;
 }
 
-void print_move_list(const std::vector<move_t> &move_list) {
+void print_move_list(const MoveList &move_list) {
   std::set<std::string> moves;
   for (const move_t move : move_list)
     moves.insert(string_from_move(move));
@@ -314,8 +720,7 @@ void print_move_list(const std::vector<move_t> &move_list) {
   std::cout << std::endl;
 }
 
-void print_algebraic_move_list(const Board &board,
-                               const std::vector<move_t> &move_list) {
+void print_algebraic_move_list(const Board &board, const MoveList &move_list) {
   std::set<std::string> moves;
   for (const move_t move : move_list)
     moves.insert(board.algebraic_notation(move));
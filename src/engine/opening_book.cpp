@@ -1,6 +1,7 @@
 
 #include "opening_book.hpp"
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <sstream>
@@ -108,7 +109,6 @@ std::string OpeningBook::book_moves_string(const Board &board) const {
   std::sort(freq_pairs.begin(), freq_pairs.end(),
             std::greater<std::pair<int, move_t>>());
 
-  const auto legal_moves = board.legal_moves();
   for (const auto &[freq, move] : freq_pairs) {
     result << board.algebraic_notation(move) << ": " << freq << ", ";
   }
@@ -0,0 +1,115 @@
+
+#include "pawn_structure.hpp"
+
+#include "perf_counter.hpp"
+#include "piece_values.hpp"
+
+static constexpr score_t DOUBLED_PAWN = make_score(-10, -20);
+static constexpr score_t ISOLATED_PAWN = make_score(-10, -15);
+static constexpr score_t BACKWARD_PAWN = make_score(-8, -10);
+// Indexed by the rank of the passed pawn, from its own side
+static constexpr score_t PASSED_PAWN[8] = {
+    make_score(0, 0),   make_score(5, 10),  make_score(10, 15),
+    make_score(15, 25), make_score(25, 40), make_score(40, 65),
+    make_score(60, 100), make_score(0, 0),
+};
+// Indexed by how many ranks in front of the king the pawn is
+static constexpr score_t PAWN_SHIELD[3] = {
+    make_score(0, 0),
+    make_score(12, 0),
+    make_score(6, 0),
+};
+
+// Each side's terms are computed from white's point of view: black's pawns
+// are mirrored onto white's side of the board first
+static constexpr inline bitboard_t flip_ranks(const bitboard_t bb) {
+  return __builtin_bswap64(bb);
+}
+
+static constexpr inline bitboard_t fill_north(bitboard_t bb) {
+  bb |= bb << 8;
+  bb |= bb << 16;
+  bb |= bb << 32;
+  return bb;
+}
+
+static constexpr inline bitboard_t fill_south(bitboard_t bb) {
+  bb |= bb >> 8;
+  bb |= bb >> 16;
+  bb |= bb >> 32;
+  return bb;
+}
+
+// The squares beside each square of the bitboard
+static constexpr inline bitboard_t adjacent(const bitboard_t bb) {
+  return ((bb & ~FILE_H_BB) << 1) | ((bb & ~FILE_A_BB) >> 1);
+}
+
+// The pawn structure score of the pawns moving north, against the pawns
+// moving south
+static score_t side_pawn_structure(const bitboard_t own_pawns,
+                                   const bitboard_t their_pawns) {
+  const bitboard_t own_files = fill_north(fill_south(own_pawns));
+  const bitboard_t their_attacks = shift_south(adjacent(their_pawns));
+  // The squares in front of their pawns, and those they can capture on
+  const bitboard_t their_front_span = fill_south(shift_south(their_pawns));
+  const bitboard_t their_control =
+      their_front_span | adjacent(their_front_span);
+
+  const bitboard_t doubled = own_pawns & fill_south(shift_south(own_pawns));
+  const bitboard_t isolated = own_pawns & ~adjacent(own_files);
+  // Pawns which no neighbouring pawn can defend by advancing, and which can't
+  // advance safely themselves
+  const bitboard_t backward = own_pawns & ~isolated &
+                              ~fill_north(adjacent(own_pawns)) &
+                              shift_south(their_attacks);
+
+  score_t result = DOUBLED_PAWN * popcount(doubled) +
+                   ISOLATED_PAWN * popcount(isolated) +
+                   BACKWARD_PAWN * popcount(backward);
+  bitboard_t passed = own_pawns & ~their_control & ~doubled;
+  while (passed)
+    result += PASSED_PAWN[pop_lsb(passed) / 8];
+  return result;
+}
+
+score_t evaluate_pawn_structure(const bitboard_t white_pawns,
+                                const bitboard_t black_pawns) {
+  return side_pawn_structure(white_pawns, black_pawns) -
+         side_pawn_structure(flip_ranks(black_pawns), flip_ranks(white_pawns));
+}
+
+// Only kings which have castled or stayed home, on the first rank and on the
+// wings, count as sheltered
+static score_t side_pawn_shield(const bitboard_t own_pawns, const int king64) {
+  const int file = king64 % 8;
+  if (king64 >= 8 || (file >= 3 && file <= 4))
+    return 0;
+  const bitboard_t king_files = square_bb(king64) | adjacent(square_bb(king64));
+  return PAWN_SHIELD[1] * popcount(own_pawns & (king_files << 8)) +
+         PAWN_SHIELD[2] * popcount(own_pawns & (king_files << 16));
+}
+
+score_t evaluate_pawn_shield(const Board &board) {
+  const int white_king = lsb(board.pieces(WHITE_KING));
+  const int black_king = lsb(flip_ranks(board.pieces(BLACK_KING)));
+  return side_pawn_shield(board.pieces(WHITE_PAWN), white_king) -
+         side_pawn_shield(flip_ranks(board.pieces(BLACK_PAWN)), black_king);
+}
+
+score_t PawnTable::probe(const Board &board) {
+  const hash_t pawn_hash = board.pawn_hash();
+  Entry &entry = m_entries[pawn_hash & (m_entries.size() - 1)];
+  if (entry.pawn_hash != pawn_hash) {
+    perf_counter.increment("PT_miss");
+    entry.pawn_hash = pawn_hash;
+    entry.score = evaluate_pawn_structure(board.pieces(WHITE_PAWN),
+                                          board.pieces(BLACK_PAWN));
+  }
+  return entry.score;
+}
+
+score_t evaluate_pawns(const Board &board) {
+  thread_local PawnTable pawn_table;
+  return pawn_table.probe(board) + evaluate_pawn_shield(board);
+}
@@ -0,0 +1,39 @@
+
+#pragma once
+
+#include "bitboard.hpp"
+#include "board.hpp"
+#include "types.hpp"
+
+#include <vector>
+
+// Pawn structure terms for both sides, from white's perspective: passed,
+// doubled, isolated and backward pawns. These depend only on where the pawns
+// are, so they are cached by the board's pawn hash.
+score_t evaluate_pawn_structure(const bitboard_t white_pawns,
+                                const bitboard_t black_pawns);
+
+// The bonus for the pawns sheltering each side's king, from white's
+// perspective. This depends on the kings too, so it is not cached.
+score_t evaluate_pawn_shield(const Board &board);
+
+// A fixed-size cache of evaluate_pawn_structure, indexed by pawn hash. Pawns
+// move rarely compared to pieces, so nearly every probe hits. Each search
+// thread has its own, so there is no need for synchronization.
+class PawnTable {
+  struct Entry {
+    hash_t pawn_hash = 0;
+    score_t score = 0; // Positions without pawns hash to 0 and score 0
+  };
+  std::vector<Entry> m_entries;
+
+public:
+  explicit PawnTable(const size_t num_entries = 1 << 14)
+      : m_entries(num_entries) {}
+
+  score_t probe(const Board &board);
+};
+
+// The pawn structure and pawn shield terms of the board, from white's
+// perspective, using this thread's pawn table
+score_t evaluate_pawns(const Board &board);
@@ -0,0 +1,104 @@
+#include "perft.hpp"
+
+#include <algorithm>
+
+bool PerftTable::probe(const hash_t hash, const int depth,
+                       size_t &count) const noexcept {
+  if (m_entries.empty())
+    return false;
+  const hash_t entry_key = key(hash, depth);
+  const Entry &entry = m_entries[entry_key % m_entries.size()];
+  const uint64_t entry_count = entry.count.load(std::memory_order_relaxed);
+  if ((entry.check.load(std::memory_order_relaxed) ^ entry_count) != entry_key)
+    return false;
+  count = entry_count;
+  return true;
+}
+
+void PerftTable::store(const hash_t hash, const int depth,
+                       const size_t count) noexcept {
+  if (m_entries.empty())
+    return;
+  const hash_t entry_key = key(hash, depth);
+  Entry &entry = m_entries[entry_key % m_entries.size()];
+  entry.check.store(entry_key ^ count, std::memory_order_relaxed);
+  entry.count.store(count, std::memory_order_relaxed);
+}
+
+// The slow but obviously correct answer to Board::gives_check
+[[maybe_unused]] static bool checks_when_made(Board &board, const move_t move) {
+  board.make_move(move);
+  const bool result = board.king_in_check();
+  board.unmake_move();
+  return result;
+}
+
+size_t perft(Board &board, const int depth, PerftTable *table) {
+  if (depth <= 0)
+    return 1;
+  // Probe before generating any moves, so that a hit saves the generation too
+  size_t result = 0;
+  if (depth >= 2 && table && table->probe(board.hash(), depth, result))
+    return result;
+  const MoveList legal_moves = board.legal_moves();
+  if (depth == 1)
+    return legal_moves.size();
+
+  for (const move_t move : legal_moves) {
+    ASSERT_MSG(board.gives_check(move) == checks_when_made(board, move),
+               "gives_check(%s) is wrong in %s", string_from_move(move).c_str(),
+               board.fen().c_str());
+    const bool legal = board.make_move(move);
+    ASSERT_MSG(legal, "Generated illegal move %s",
+               string_from_move(move).c_str());
+    result += perft(board, depth - 1, table);
+    board.unmake_move();
+  }
+  if (table)
+    table->store(board.hash(), depth, result);
+  return result;
+}
+
+std::vector<std::pair<move_t, size_t>>
+perft_divide(const Board &board, const int depth, PerftTable *table,
+             const unsigned num_threads) {
+  std::vector<std::pair<move_t, size_t>> result;
+  if (depth <= 0)
+    return result;
+  const MoveList legal_moves = board.legal_moves();
+  for (const move_t move : legal_moves)
+    result.emplace_back(move, 0);
+
+  // Each thread repeatedly claims the next unsearched root move, so that one
+  // large subtree doesn't leave the other threads idle
+  std::atomic<size_t> next_move = 0;
+  const auto worker = [&]() {
+    Board tmp(board);
+    for (size_t idx = next_move++; idx < result.size(); idx = next_move++) {
+      tmp.make_move(result[idx].first);
+      result[idx].second = perft(tmp, depth - 1, table);
+      tmp.unmake_move();
+    }
+  };
+
+  const unsigned thread_count =
+      std::clamp<unsigned>(num_threads, 1, std::max<size_t>(result.size(), 1));
+  std::vector<std::thread> threads;
+  for (unsigned idx = 1; idx < thread_count; ++idx)
+    threads.emplace_back(worker);
+  worker();
+  for (std::thread &thread : threads)
+    thread.join();
+  return result;
+}
+
+size_t parallel_perft(const Board &board, const int depth, PerftTable *table,
+                      const unsigned num_threads) {
+  if (depth <= 0)
+    return 1;
+  size_t result = 0;
+  for (const auto &[move, count] :
+       perft_divide(board, depth, table, num_threads))
+    result += count;
+  return result;
+}
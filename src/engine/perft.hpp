@@ -0,0 +1,52 @@
+#pragma once
+
+#include "board.hpp"
+#include "hash.hpp"
+#include "move.hpp"
+
+#include <atomic>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Perft counts the leaves of the legal move tree to a fixed depth, which makes
+// it the standard correctness (and speed) test for move generation.
+
+// A table memoizing (hash, depth) -> node count, shared between perft threads
+// without locks. Each slot stores the count alongside the key XOR'ed with it,
+// so that a slot torn by two concurrent writes never matches a probe.
+class PerftTable {
+  struct Entry {
+    std::atomic<uint64_t> check{0}; // key ^ count
+    std::atomic<uint64_t> count{0};
+  };
+  std::vector<Entry> m_entries;
+
+  static constexpr inline hash_t key(const hash_t hash, const int depth) {
+    return hash ^ (depth * 0x9E3779B97F4A7C15ULL);
+  }
+
+public:
+  explicit PerftTable(const size_t size_mb = 16)
+      : m_entries((size_mb << 20) / sizeof(Entry)) {}
+
+  bool probe(const hash_t hash, const int depth, size_t &count) const noexcept;
+  void store(const hash_t hash, const int depth, const size_t count) noexcept;
+};
+
+// The number of leaves at the given depth below board. Leaves one move away
+// are counted from the size of the legal move list rather than by making each
+// move, and subtrees are looked up in and stored to the table, if given. A
+// depth of 0 or less counts the board itself.
+size_t perft(Board &board, const int depth, PerftTable *table = nullptr);
+
+// The perft count below each legal move of board, with the moves split across
+// num_threads threads. Empty for a depth of 0 or less.
+std::vector<std::pair<move_t, size_t>>
+perft_divide(const Board &board, const int depth, PerftTable *table = nullptr,
+             const unsigned num_threads = std::thread::hardware_concurrency());
+
+size_t
+parallel_perft(const Board &board, const int depth,
+               PerftTable *table = nullptr,
+               const unsigned num_threads = std::thread::hardware_concurrency());
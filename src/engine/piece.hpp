@@ -12,15 +12,13 @@
 enum Piece {
   WHITE_QUEEN = 0,
   WHITE_ROOK = 1,
-  WHITE_PAWN = 2,
-  WHITE_ENDGAME_KING = 3, // Used exclusively for endgame valuation
+  WHITE_PAWN = 2, // 3 unused
   WHITE_BISHOP = 4,
   WHITE_KNIGHT = 5,
   WHITE_KING = 6,
   BLACK_QUEEN = 8,
   BLACK_ROOK = 9,
-  BLACK_PAWN = 10,
-  BLACK_ENDGAME_KING = 11, // Used exclusively for endgame valuation
+  BLACK_PAWN = 10, // 11 unused
   BLACK_BISHOP = 12,
   BLACK_KNIGHT = 13,
   BLACK_KING = 14,
@@ -1,7 +1,6 @@
-
 #include "piece_values.hpp"
 
-int piece_values[16][120];
+score_t piece_values[16][120];
 
 void init_piece_values() {
   for (piece_t piece = 0; piece < 16; ++piece) {
@@ -12,9 +11,12 @@ void init_piece_values() {
         const bool white_piece = piece < 8;
         const square_t flipped_square = white_piece ? flip_square(sq) : sq;
         const square_t table_idx = get_square_64(flipped_square);
-        const int raw_offset = square_table[piece][table_idx];
-        const int offset = white_piece ? raw_offset : -raw_offset;
-        piece_values[piece][sq] = base_piece_values[piece] + offset;
+        const int sign = white_piece ? 1 : -1;
+        piece_values[piece][sq] = make_score(
+            base_piece_values[piece] +
+                sign * middlegame_square_table[piece][table_idx],
+            base_piece_values[piece] +
+                sign * endgame_square_table[piece][table_idx]);
       }
     }
   }
@@ -5,8 +5,48 @@
 #include "square.hpp"
 #include "types.hpp"
 
+#include <algorithm>
 #include <array>
 
+// A middlegame and an endgame value packed into one integer, with the endgame
+// value in the upper 16 bits, so that both can be added up at once
+constexpr inline score_t make_score(const int middlegame, const int endgame) {
+  return (score_t)((uint32_t)endgame << 16) + middlegame;
+}
+constexpr inline int middlegame_value(const score_t score) {
+  return (int16_t)(uint16_t)(uint32_t)score;
+}
+constexpr inline int endgame_value(const score_t score) {
+  return (int16_t)(uint16_t)((uint32_t)(score + 0x8000) >> 16);
+}
+
+// The game phase falls from MAX_PHASE with all the pieces on the board to 0
+// with only kings and pawns, as pieces are traded
+enum {
+  KNIGHT_PHASE = 1,
+  BISHOP_PHASE = 1,
+  ROOK_PHASE = 2,
+  QUEEN_PHASE = 4,
+  MAX_PHASE = 4 * KNIGHT_PHASE + 4 * BISHOP_PHASE + 4 * ROOK_PHASE +
+              2 * QUEEN_PHASE,
+};
+
+static const int piece_phases[16] = {
+    QUEEN_PHASE,  ROOK_PHASE,   0, 0, //
+    BISHOP_PHASE, KNIGHT_PHASE, 0, 0, // White pieces
+    QUEEN_PHASE,  ROOK_PHASE,   0, 0, //
+    BISHOP_PHASE, KNIGHT_PHASE, 0, 0, // Black pieces
+};
+
+// Interpolates between the middlegame and endgame values by the game phase.
+// Promotions can raise the phase past MAX_PHASE, which counts as middlegame.
+constexpr inline int taper(const score_t score, const int phase) {
+  const int middlegame_weight = std::min<int>(phase, MAX_PHASE);
+  return (middlegame_value(score) * middlegame_weight +
+          endgame_value(score) * (MAX_PHASE - middlegame_weight)) /
+         MAX_PHASE;
+}
+
 // Source: https://www.chessprogramming.org/Simplified_Evaluation_Function
 enum {
   PAWN_VALUE = 100,
@@ -90,6 +130,19 @@ static const int king_middlegame_square_table[64] = {
     20,  30,  10,  0,   0,   10,  30,  20,  // 1
 };
 
+// Passed pawns matter more as the pieces come off, so in the endgame, pawns are
+// pushed however exposed that leaves them
+static const int pawn_endgame_square_table[64] = {
+    0,  0,  0,  0,  0,  0,  0,  0,  // 8
+    90, 90, 90, 90, 90, 90, 90, 90, // 7
+    50, 50, 50, 50, 50, 50, 50, 50, // 6
+    30, 30, 30, 30, 30, 30, 30, 30, // 5
+    15, 15, 15, 15, 15, 15, 15, 15, // 4
+    5,  5,  5,  5,  5,  5,  5,  5,  // 3
+    0,  0,  0,  0,  0,  0,  0,  0,  // 2
+    0,  0,  0,  0,  0,  0,  0,  0,  // 1
+};
+
 static const int king_endgame_square_table[64] = {
     -50, -40, -30, -20, -20, -30, -40, -50, // 8
     -30, -20, -10, 0,   0,   -10, -20, -30, // 7
@@ -103,11 +156,11 @@ static const int king_endgame_square_table[64] = {
 
 static const int empty_table[64] = {0};
 
-static const int *square_table[16] = {
+static const int *middlegame_square_table[16] = {
     queen_square_table,
     rook_square_table,
     pawn_square_table,
-    king_endgame_square_table, //
+    empty_table, //
     bishop_square_table,
     knight_square_table,
     king_middlegame_square_table,
@@ -115,17 +168,38 @@ static const int *square_table[16] = {
     queen_square_table,
     rook_square_table,
     pawn_square_table,
-    king_endgame_square_table, //
+    empty_table, //
     bishop_square_table,
     knight_square_table,
     king_middlegame_square_table,
     empty_table, // Black pieces
 };
 
+static const int *endgame_square_table[16] = {
+    queen_square_table,
+    rook_square_table,
+    pawn_endgame_square_table,
+    empty_table, //
+    bishop_square_table,
+    knight_square_table,
+    king_endgame_square_table,
+    empty_table, // White pieces
+    queen_square_table,
+    rook_square_table,
+    pawn_endgame_square_table,
+    empty_table, //
+    bishop_square_table,
+    knight_square_table,
+    king_endgame_square_table,
+    empty_table, // Black pieces
+};
+
 constexpr inline square_t flip_square(const square_t sq) {
   return sq + 110 - 20 * (sq / 10);
 }
 
-extern int piece_values[16][120];
+// The material and piece-square value of each piece on each square, for the
+// middlegame and the endgame, from white's perspective
+extern score_t piece_values[16][120];
 
 void init_piece_values();
@@ -1,10 +1,20 @@
 
 #pragma once
 
+#include "move_history.hpp"
+#include "time_manager.hpp"
 #include "timeit.hpp"
+#include <array>
 #include <atomic>
 #include <chrono>
 
+// What the search knows about each position on the path it is searching,
+// indexed by ply
+struct SearchStackEntry {
+  bool in_check = false;
+  int static_eval = 0; // Only set when not in check
+};
+
 struct SearchInfo {
   // We check whether the search should stop, once every 'refresh_frequency'
   // nodes in our search. This should be small enough so we don't waste time
@@ -13,23 +23,33 @@ struct SearchInfo {
   static const int refresh_frequency = 1024;
 
   using time_t = std::chrono::time_point<std::chrono::high_resolution_clock>;
-  time_t start_time;                   // The start time, as a time point
-  float seconds_to_search = 1000000.0; // Number of seconds to search
-  int depth = 100;                     // Maximum depth to search
-  bool infinite = false;               // True if we are searching infinitely
+  time_t start_time;        // The start time, as a time point
+  TimeManager time_manager; // How long to search for
+  int depth = 100;          // Maximum depth to search
+  bool infinite = false;    // True if we are searching infinitely
   bool send_info = false;
+  int num_threads = 1;      // Number of threads to search with
 
   long nodes = 0; // Number of nodes searched so far
 
+  MoveHistory history; // Move ordering statistics for this thread's search
+  std::array<SearchStackEntry, MAX_SEARCH_PLY> stack{};
+
   std::atomic<bool> has_quit = false; // Received a quit interrupt from UCI
   bool is_stopped = false;            // Stopped search for any reason
 
   SearchInfo() : start_time(now()) {}
+  SearchInfo(const TimeManager &time_manager, const int depth,
+             const bool infinite, const bool send_info = true,
+             const int num_threads = 1)
+      : start_time(now()), time_manager(time_manager), depth(depth),
+        infinite(infinite), send_info(send_info), num_threads(num_threads),
+        has_quit(false), is_stopped(false) {}
   SearchInfo(const float seconds_to_search, const int depth,
-             const bool infinite, const bool send_info = true)
-      : start_time(now()), seconds_to_search(seconds_to_search), depth(depth),
-        infinite(infinite), send_info(send_info), has_quit(false),
-        is_stopped(false) {}
+             const bool infinite, const bool send_info = true,
+             const int num_threads = 1)
+      : SearchInfo(TimeManager::fixed(seconds_to_search), depth, infinite,
+                   send_info, num_threads) {}
   SearchInfo(const SearchInfo &other)
-      : SearchInfo(other.seconds_to_search, other.depth, other.infinite) {}
+      : SearchInfo(other.time_manager, other.depth, other.infinite) {}
 };
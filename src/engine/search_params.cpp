@@ -0,0 +1,45 @@
+
+#include "search_params.hpp"
+
+#include <cmath>
+
+SearchParameters search_params;
+
+const std::vector<TunableParameter> tunable_parameters = {
+    {"ReverseFutilityMaxDepth", &search_params.reverse_futility_max_depth, 0,
+     20},
+    {"ReverseFutilityMargin", &search_params.reverse_futility_margin, 0, 1000},
+    {"FutilityMaxDepth", &search_params.futility_max_depth, 0, 20},
+    {"FutilityBaseMargin", &search_params.futility_base_margin, 0, 1000},
+    {"FutilityMargin", &search_params.futility_margin, 0, 1000},
+    {"LateMovePruningMaxDepth", &search_params.late_move_pruning_max_depth, 0,
+     20},
+    {"LateMovePruningBase", &search_params.late_move_pruning_base, 0, 100},
+    {"NullMoveMinDepth", &search_params.null_move_min_depth, 1, 20},
+    {"NullMoveBase", &search_params.null_move_base, 0, 10},
+    {"NullMoveDepthDivisor", &search_params.null_move_depth_divisor, 1, 20},
+    {"NullMoveEvalDivisor", &search_params.null_move_eval_divisor, 1, 1000},
+    {"NullMoveEvalMax", &search_params.null_move_eval_max, 0, 10},
+    {"NullMoveVerificationDepth",
+     &search_params.null_move_verification_depth, 1, 100},
+    {"LMRMinDepth", &search_params.lmr_min_depth, 3, 100},
+    {"LMRMinMoves", &search_params.lmr_min_moves, 1, 100},
+    {"LMRBase", &search_params.lmr_base, 0, 500},
+    {"LMRDivisor", &search_params.lmr_divisor, 1, 1000},
+};
+
+int lmr_reductions[LMR_TABLE_SIZE][LMR_TABLE_SIZE];
+
+void init_search_params() {
+  for (int depth = 0; depth < LMR_TABLE_SIZE; ++depth) {
+    for (int moves = 0; moves < LMR_TABLE_SIZE; ++moves) {
+      const double reduction =
+          (depth == 0 || moves == 0)
+              ? 0.0
+              : search_params.lmr_base / 100.0 +
+                    std::log(depth) * std::log(moves) * 100.0 /
+                        search_params.lmr_divisor;
+      lmr_reductions[depth][moves] = static_cast<int>(reduction);
+    }
+  }
+}
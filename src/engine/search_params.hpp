@@ -0,0 +1,61 @@
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+// The parameters of the search's pruning and reduction heuristics. They are
+// exposed as UCI options through the table below, so that they can be tuned
+// without rebuilding.
+struct SearchParameters {
+  // Reverse futility pruning: at shallow depths, a static evaluation which
+  // beats beta by a margin per ply is assumed to hold up
+  int reverse_futility_max_depth = 6;
+  int reverse_futility_margin = 120;
+  // Futility pruning: at shallow depths, quiet moves can't raise a static
+  // evaluation which trails alpha by a margin per ply
+  int futility_max_depth = 3;
+  int futility_base_margin = 100;
+  int futility_margin = 150;
+  // Late move pruning: at shallow depths, only the first
+  // base + depth * depth quiet moves are searched
+  int late_move_pruning_max_depth = 4;
+  int late_move_pruning_base = 3;
+  // Null move pruning: passing and still beating beta in a search reduced by
+  // base + depth / depth_divisor + (eval - beta) / eval_divisor (at most
+  // eval_max) plies is taken as a cutoff. From verification_depth on, the
+  // cutoff is confirmed by a reduced search without the null move.
+  int null_move_min_depth = 3;
+  int null_move_base = 3;
+  int null_move_depth_divisor = 4;
+  int null_move_eval_divisor = 200;
+  int null_move_eval_max = 3;
+  int null_move_verification_depth = 12;
+  // Late move reductions: quiet moves late in the ordering are searched
+  // ln(depth) * ln(move number) * 100 / divisor plies shallower, but never
+  // below depth 1. Shallower than min_depth, that leaves nothing to reduce.
+  int lmr_min_depth = 3;
+  int lmr_min_moves = 3;
+  int lmr_base = 75;     // In hundredths of a ply
+  int lmr_divisor = 225; // In hundredths
+};
+
+extern SearchParameters search_params;
+
+struct TunableParameter {
+  std::string name;
+  int *value;
+  int min, max;
+};
+
+// Every SearchParameters field, by its UCI option name
+extern const std::vector<TunableParameter> tunable_parameters;
+
+enum { LMR_TABLE_SIZE = 64 };
+// The reduction for the quiet move with the given (0-indexed) number at the
+// given depth, both capped at LMR_TABLE_SIZE - 1
+extern int lmr_reductions[LMR_TABLE_SIZE][LMR_TABLE_SIZE];
+
+// Recomputes the tables derived from search_params. Must be called after
+// changing any of them.
+void init_search_params();
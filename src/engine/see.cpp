@@ -0,0 +1,79 @@
+
+#include "see.hpp"
+
+#include "bitboard.hpp"
+#include "piece_values.hpp"
+
+#include <algorithm>
+
+// Indexed by white piece. The king's value is large enough that capturing it
+// always ends the exchange, so a king only recaptures onto undefended squares.
+static constexpr int see_values[8] = {
+    QUEEN_VALUE, ROOK_VALUE, PAWN_VALUE, 0, BISHOP_VALUE, KNIGHT_VALUE,
+    20000,       0,
+};
+
+int see(const Board &board, const move_t move) {
+  const int from64 = get_square_64(move_from(move));
+  const int to64 = get_square_64(move_to(move));
+  const int side = board.m_side_to_move;
+
+  // gain[d] is the material won by the side making the d-th capture, assuming
+  // the exchange stops right after it
+  int gain[32];
+  int depth = 0;
+  bitboard_t occ = board.occupied() ^ square_bb(from64);
+  if (move_flag(move) == EN_PASSANT_MOVE) {
+    gain[0] = PAWN_VALUE;
+    occ ^= square_bb_120(move_to(move) + ((side == WHITE) ? -10 : 10));
+  } else {
+    gain[0] = move_captured(move)
+                  ? see_values[to_white(captured_piece(move))]
+                  : 0;
+  }
+  // The value of the piece standing on the target square
+  int on_square = see_values[to_white(moved_piece(move))];
+  if (move_promoted(move)) {
+    on_square = see_values[to_white(promoted_piece(move))];
+    gain[0] += on_square - PAWN_VALUE;
+  }
+
+  bitboard_t attackers = (board.attackers_to(to64, WHITE, occ) |
+                          board.attackers_to(to64, BLACK, occ)) &
+                         occ;
+  int cur_side = !side;
+  while (depth + 1 < 32) {
+    const bitboard_t own_attackers = attackers & board.side_pieces(cur_side);
+    if (!own_attackers)
+      break;
+
+    // Recapture with the least valuable attacker
+    bitboard_t attacker = EMPTY_BB;
+    piece_t attacker_piece = INVALID_PIECE;
+    for (const piece_t piece : {WHITE_PAWN, WHITE_KNIGHT, WHITE_BISHOP,
+                                WHITE_ROOK, WHITE_QUEEN, WHITE_KING}) {
+      attacker = own_attackers & board.pieces(piece | (cur_side << 3));
+      if (attacker) {
+        attacker_piece = piece;
+        break;
+      }
+    }
+
+    depth++;
+    gain[depth] = on_square - gain[depth - 1];
+    on_square = see_values[attacker_piece];
+    occ ^= attacker & -attacker;
+    // Sliders behind the piece that just captured may now see the square
+    attackers = (board.attackers_to(to64, WHITE, occ) |
+                 board.attackers_to(to64, BLACK, occ)) &
+                occ;
+    cur_side = !cur_side;
+  }
+
+  // Each side may stop recapturing whenever continuing would lose material
+  while (depth > 0) {
+    gain[depth - 1] = -std::max(-gain[depth - 1], gain[depth]);
+    depth--;
+  }
+  return gain[0];
+}
@@ -0,0 +1,14 @@
+
+#pragma once
+
+#include "board.hpp"
+#include "move.hpp"
+
+// Static Exchange Evaluation: the material the side to move gains by making
+// the given capture, if both sides then keep recapturing on the target square
+// with their least valuable attacker for as long as that is profitable. Pieces
+// behind a capturing slider join the exchange once it moves out of the way.
+//
+// Only material is counted, so checks, pins and promotions after the first
+// move are ignored.
+int see(const Board &board, const move_t move);
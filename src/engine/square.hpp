@@ -126,94 +126,100 @@ constexpr inline square_t get_square_120_rc(const int row, const int col) {
 
 #define LUT_SQUARE
 #ifdef LUT_SQUARE
+// The lookup tables live at namespace scope: as locals of the constexpr
+// functions below they would be rebuilt on the stack on every call.
+inline constexpr bool _valid_square[120] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, //
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, //
+    0, 1, 1, 1, 1, 1, 1, 1, 1, 0, //
+    0, 1, 1, 1, 1, 1, 1, 1, 1, 0, //
+    0, 1, 1, 1, 1, 1, 1, 1, 1, 0, //
+    0, 1, 1, 1, 1, 1, 1, 1, 1, 0, //
+    0, 1, 1, 1, 1, 1, 1, 1, 1, 0, //
+    0, 1, 1, 1, 1, 1, 1, 1, 1, 0, //
+    0, 1, 1, 1, 1, 1, 1, 1, 1, 0, //
+    0, 1, 1, 1, 1, 1, 1, 1, 1, 0, //
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, //
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, //
+};
+
+inline constexpr int _get_square_row[120] = {
+    9, 9, 9, 9, 9, 9, 9, 9, 9, 9, //
+    9, 9, 9, 9, 9, 9, 9, 9, 9, 9, //
+    9, 0, 0, 0, 0, 0, 0, 0, 0, 9, //
+    9, 1, 1, 1, 1, 1, 1, 1, 1, 9, //
+    9, 2, 2, 2, 2, 2, 2, 2, 2, 9, //
+    9, 3, 3, 3, 3, 3, 3, 3, 3, 9, //
+    9, 4, 4, 4, 4, 4, 4, 4, 4, 9, //
+    9, 5, 5, 5, 5, 5, 5, 5, 5, 9, //
+    9, 6, 6, 6, 6, 6, 6, 6, 6, 9, //
+    9, 7, 7, 7, 7, 7, 7, 7, 7, 9, //
+    9, 9, 9, 9, 9, 9, 9, 9, 9, 9, //
+    9, 9, 9, 9, 9, 9, 9, 9, 9, 9, //
+};
+
+inline constexpr int _get_square_col[120] = {
+    9, 9, 9, 9, 9, 9, 9, 9, 9, 9, //
+    9, 9, 9, 9, 9, 9, 9, 9, 9, 9, //
+    9, 0, 1, 2, 3, 4, 5, 6, 7, 9, //
+    9, 0, 1, 2, 3, 4, 5, 6, 7, 9, //
+    9, 0, 1, 2, 3, 4, 5, 6, 7, 9, //
+    9, 0, 1, 2, 3, 4, 5, 6, 7, 9, //
+    9, 0, 1, 2, 3, 4, 5, 6, 7, 9, //
+    9, 0, 1, 2, 3, 4, 5, 6, 7, 9, //
+    9, 0, 1, 2, 3, 4, 5, 6, 7, 9, //
+    9, 0, 1, 2, 3, 4, 5, 6, 7, 9, //
+    9, 9, 9, 9, 9, 9, 9, 9, 9, 9, //
+    9, 9, 9, 9, 9, 9, 9, 9, 9, 9, //
+};
+
+inline constexpr int _get_square_64[120] = {
+    99, 99, 99, 99, 99, 99, 99, 99, 99, 99, //
+    99, 99, 99, 99, 99, 99, 99, 99, 99, 99, //
+    99, 0,  1,  2,  3,  4,  5,  6,  7,  99, //
+    99, 8,  9,  10, 11, 12, 13, 14, 15, 99, //
+    99, 16, 17, 18, 19, 20, 21, 22, 23, 99, //
+    99, 24, 25, 26, 27, 28, 29, 30, 31, 99, //
+    99, 32, 33, 34, 35, 36, 37, 38, 39, 99, //
+    99, 40, 41, 42, 43, 44, 45, 46, 47, 99, //
+    99, 48, 49, 50, 51, 52, 53, 54, 55, 99, //
+    99, 56, 57, 58, 59, 60, 61, 62, 63, 99, //
+    99, 99, 99, 99, 99, 99, 99, 99, 99, 99, //
+    99, 99, 99, 99, 99, 99, 99, 99, 99, 99, //
+};
+
+inline constexpr int _get_square_120[64] = {
+    21, 22, 23, 24, 25, 26, 27, 28, //
+    31, 32, 33, 34, 35, 36, 37, 38, //
+    41, 42, 43, 44, 45, 46, 47, 48, //
+    51, 52, 53, 54, 55, 56, 57, 58, //
+    61, 62, 63, 64, 65, 66, 67, 68, //
+    71, 72, 73, 74, 75, 76, 77, 78, //
+    81, 82, 83, 84, 85, 86, 87, 88, //
+    91, 92, 93, 94, 95, 96, 97, 98, //
+};
 
 constexpr inline bool valid_square(const square_t square) {
-  constexpr bool _valid_square[120] = {
-      0, 0, 0, 0, 0, 0, 0, 0, 0, 0, //
-      0, 0, 0, 0, 0, 0, 0, 0, 0, 0, //
-      0, 1, 1, 1, 1, 1, 1, 1, 1, 0, //
-      0, 1, 1, 1, 1, 1, 1, 1, 1, 0, //
-      0, 1, 1, 1, 1, 1, 1, 1, 1, 0, //
-      0, 1, 1, 1, 1, 1, 1, 1, 1, 0, //
-      0, 1, 1, 1, 1, 1, 1, 1, 1, 0, //
-      0, 1, 1, 1, 1, 1, 1, 1, 1, 0, //
-      0, 1, 1, 1, 1, 1, 1, 1, 1, 0, //
-      0, 1, 1, 1, 1, 1, 1, 1, 1, 0, //
-      0, 0, 0, 0, 0, 0, 0, 0, 0, 0, //
-      0, 0, 0, 0, 0, 0, 0, 0, 0, 0, //
-  };
   ASSERT(0 <= square && square < 120);
   return _valid_square[square];
 }
 
 constexpr inline int get_square_row(const square_t square) {
-  constexpr int _get_square_row[120] = {
-      9, 9, 9, 9, 9, 9, 9, 9, 9, 9, //
-      9, 9, 9, 9, 9, 9, 9, 9, 9, 9, //
-      9, 0, 0, 0, 0, 0, 0, 0, 0, 9, //
-      9, 1, 1, 1, 1, 1, 1, 1, 1, 9, //
-      9, 2, 2, 2, 2, 2, 2, 2, 2, 9, //
-      9, 3, 3, 3, 3, 3, 3, 3, 3, 9, //
-      9, 4, 4, 4, 4, 4, 4, 4, 4, 9, //
-      9, 5, 5, 5, 5, 5, 5, 5, 5, 9, //
-      9, 6, 6, 6, 6, 6, 6, 6, 6, 9, //
-      9, 7, 7, 7, 7, 7, 7, 7, 7, 9, //
-      9, 9, 9, 9, 9, 9, 9, 9, 9, 9, //
-      9, 9, 9, 9, 9, 9, 9, 9, 9, 9, //
-  };
   ASSERT(valid_square(square));
   return _get_square_row[square];
 }
 
 constexpr inline int get_square_col(const square_t square) {
-  constexpr int _get_square_col[120] = {
-      9, 9, 9, 9, 9, 9, 9, 9, 9, 9, //
-      9, 9, 9, 9, 9, 9, 9, 9, 9, 9, //
-      9, 0, 1, 2, 3, 4, 5, 6, 7, 9, //
-      9, 0, 1, 2, 3, 4, 5, 6, 7, 9, //
-      9, 0, 1, 2, 3, 4, 5, 6, 7, 9, //
-      9, 0, 1, 2, 3, 4, 5, 6, 7, 9, //
-      9, 0, 1, 2, 3, 4, 5, 6, 7, 9, //
-      9, 0, 1, 2, 3, 4, 5, 6, 7, 9, //
-      9, 0, 1, 2, 3, 4, 5, 6, 7, 9, //
-      9, 0, 1, 2, 3, 4, 5, 6, 7, 9, //
-      9, 9, 9, 9, 9, 9, 9, 9, 9, 9, //
-      9, 9, 9, 9, 9, 9, 9, 9, 9, 9, //
-  };
   ASSERT(valid_square(square));
   return _get_square_col[square];
 }
 
 constexpr inline int get_square_64(const square_t square) {
-  constexpr int _get_square_64[120] = {
-      99, 99, 99, 99, 99, 99, 99, 99, 99, 99, //
-      99, 99, 99, 99, 99, 99, 99, 99, 99, 99, //
-      99, 0,  1,  2,  3,  4,  5,  6,  7,  99, //
-      99, 8,  9,  10, 11, 12, 13, 14, 15, 99, //
-      99, 16, 17, 18, 19, 20, 21, 22, 23, 99, //
-      99, 24, 25, 26, 27, 28, 29, 30, 31, 99, //
-      99, 32, 33, 34, 35, 36, 37, 38, 39, 99, //
-      99, 40, 41, 42, 43, 44, 45, 46, 47, 99, //
-      99, 48, 49, 50, 51, 52, 53, 54, 55, 99, //
-      99, 56, 57, 58, 59, 60, 61, 62, 63, 99, //
-      99, 99, 99, 99, 99, 99, 99, 99, 99, 99, //
-      99, 99, 99, 99, 99, 99, 99, 99, 99, 99, //
-  };
   ASSERT(valid_square(square));
   return _get_square_64[square];
 }
 
 constexpr inline square_t get_square_120(const square_t square) {
-  constexpr int _get_square_120[64] = {
-      21, 22, 23, 24, 25, 26, 27, 28, //
-      31, 32, 33, 34, 35, 36, 37, 38, //
-      41, 42, 43, 44, 45, 46, 47, 48, //
-      51, 52, 53, 54, 55, 56, 57, 58, //
-      61, 62, 63, 64, 65, 66, 67, 68, //
-      71, 72, 73, 74, 75, 76, 77, 78, //
-      81, 82, 83, 84, 85, 86, 87, 88, //
-      91, 92, 93, 94, 95, 96, 97, 98, //
-  };
   ASSERT(0 <= square && square < 64);
   return _get_square_120[square];
 }
@@ -0,0 +1,54 @@
+
+#include "time_manager.hpp"
+
+#include <algorithm>
+
+// Time lost to communication with the GUI on every move, in milliseconds
+static constexpr int MOVE_OVERHEAD_MS = 50;
+// Each iteration is expected to take about this many times as long as the
+// last, with the reductions and pruning in the search
+static constexpr float ITERATION_GROWTH = 2.0;
+// Changes in score, in centipawns, small enough to be noise
+static constexpr int SCORE_DROP_MARGIN = 30;
+
+TimeManager TimeManager::from_clock(const int remaining_ms,
+                                    const int increment_ms,
+                                    const int moves_to_go) {
+  const float remaining =
+      std::max(remaining_ms - MOVE_OVERHEAD_MS, 0) / 1000.0f;
+  const float increment = increment_ms / 1000.0f;
+  const float optimum = std::min(
+      remaining / std::max(moves_to_go, 1) + 0.75f * increment,
+      0.5f * remaining);
+  const float maximum = std::min(5.0f * optimum, 0.8f * remaining);
+  return {std::max(optimum, 0.01f), std::max(maximum, 0.01f)};
+}
+
+bool TimeManager::iteration_done(const move_t best_move, const int score,
+                                 const float elapsed_seconds,
+                                 const float iteration_seconds) {
+  m_iterations++;
+  if (m_iterations > 1 && best_move == m_best_move)
+    m_stable_iterations++;
+  else
+    m_stable_iterations = 0;
+
+  // A new best move needs confirming, while one that has survived several
+  // iterations is unlikely to change with another
+  if (m_adaptive) {
+    m_scale = (m_iterations > 1 && m_stable_iterations == 0)
+                  ? 1.4f
+                  : std::max(0.5f, 1.0f - 0.1f * m_stable_iterations);
+    if (m_iterations > 1 && score < m_score - SCORE_DROP_MARGIN)
+      m_scale *= 1.3f;
+  }
+
+  m_best_move = best_move;
+  m_score = score;
+
+  if (elapsed_seconds >= std::min(optimum_seconds(), m_maximum_seconds))
+    return true;
+  // Don't start an iteration which would be cut off before it finishes
+  return elapsed_seconds + ITERATION_GROWTH * iteration_seconds >
+         m_maximum_seconds;
+}
@@ -0,0 +1,51 @@
+
+#pragma once
+
+#include "types.hpp"
+
+// Decides how long a search should take. A search has two limits:
+//   - the optimum time, after which no new iteration is started. It is scaled
+//     by how settled the search looks: a best move which keeps changing, or a
+//     score which is dropping, earns more time, and a best move which has
+//     stood for several iterations earns less.
+//   - the maximum time, at which the search is stopped even mid-iteration.
+//     Since that throws the iteration's work away, an iteration is not started
+//     unless it is expected to finish by then.
+class TimeManager {
+  float m_optimum_seconds = 1e9;
+  float m_maximum_seconds = 1e9;
+  float m_scale = 1.0;
+  bool m_adaptive = true; // Whether to scale the optimum time
+
+  // The state of the search after the last completed iteration
+  move_t m_best_move = 0;
+  int m_score = 0;
+  int m_stable_iterations = 0;
+  int m_iterations = 0;
+
+public:
+  TimeManager() = default;
+  TimeManager(const float optimum_seconds, const float maximum_seconds,
+              const bool adaptive = true)
+      : m_optimum_seconds(optimum_seconds), m_maximum_seconds(maximum_seconds),
+        m_adaptive(adaptive) {}
+
+  // Search for the given time, as for "go movetime", stopping early only when
+  // the next iteration can't finish in time
+  static TimeManager fixed(const float seconds) {
+    return {seconds, seconds, false};
+  }
+  // Budget the remaining time on the clock over the moves to go
+  static TimeManager from_clock(const int remaining_ms, const int increment_ms,
+                                const int moves_to_go);
+
+  float optimum_seconds() const { return m_optimum_seconds * m_scale; }
+  float maximum_seconds() const { return m_maximum_seconds; }
+
+  // Records the result of an iteration which finished after
+  // iteration_seconds, and returns whether the search should stop there,
+  // elapsed_seconds after it started
+  bool iteration_done(const move_t best_move, const int score,
+                      const float elapsed_seconds,
+                      const float iteration_seconds);
+};
@@ -3,67 +3,153 @@
 
 #include "perf_counter.hpp"
 
+#include <algorithm>
+#include <bit>
 #include <set>
 #include <vector>
 
 TranspositionTable transposition_table;
-TranspositionTable quiescence_table;
+
+void TranspositionTable::resize(const size_t size_mb) {
+  const size_t max_buckets =
+      (std::max<size_t>(size_mb, MIN_SIZE_MB) << 20) / sizeof(Bucket);
+  m_buckets = std::vector<Bucket>(std::bit_floor(max_buckets));
+}
+
+void TranspositionTable::clear() noexcept {
+  for (Bucket &bucket : m_buckets) {
+    for (Entry &entry : bucket.entries) {
+      entry.check.store(0, std::memory_order_relaxed);
+      entry.data.store(0, std::memory_order_relaxed);
+    }
+  }
+}
+
+int TranspositionTable::hashfull() const noexcept {
+  const size_t num_buckets =
+      std::min<size_t>(1000 / BUCKET_SIZE, m_buckets.size());
+  int result = 0;
+  for (size_t idx = 0; idx < num_buckets; ++idx) {
+    for (const Entry &entry : m_buckets[idx].entries) {
+      const uint64_t data = entry.data.load(std::memory_order_relaxed);
+      result += data != 0 && unpack(0, data).generation == m_generation;
+    }
+  }
+  return result * 1000 / (num_buckets * BUCKET_SIZE);
+}
 
 TableEntry TranspositionTable::query(const hash_t hash) const {
   perf_counter.increment("TT_query");
-  const auto it = m_table.find(hash);
-  if (it == m_table.end())
-    return TableEntry();
-  return it->second;
+  for (const Entry &entry : bucket(hash).entries) {
+    const uint64_t data = entry.data.load(std::memory_order_relaxed);
+    uint64_t eval_bits;
+    if (matches(entry, hash, data, eval_bits)) {
+      TableEntry result = unpack(hash, data);
+      result.static_eval = unpack_eval(eval_bits);
+      return result;
+    }
+  }
+  return TableEntry();
 }
 
 void TranspositionTable::insert(const Board &board, const move_t best_move,
                                 const int depth, const int value,
-                                const NodeType type) {
+                                const NodeType type, const int static_eval) {
   perf_counter.increment("TT_insert");
   const hash_t hash = board.hash();
-  const int epoch = board.fifty_move_monovariant();
-  const TableEntry previous_entry = query(hash);
-  const TableEntry new_entry = {hash, best_move, depth, value, type, epoch};
+  const uint64_t new_data = pack(best_move, depth, value, type, m_generation);
+  const uint64_t new_eval_bits = pack_eval(static_eval);
+  Bucket &bucket = this->bucket(hash);
 
-  bool replace = false;
-  if (previous_entry.depth > depth) {
-    // If the previous entry searched deeper, keep that one
-    perf_counter.increment("TT_insert_depth_too_low");
-    replace = false;
-  } else if (previous_entry.depth < depth) {
-    // If the new entry searched deeper, keep it
-    perf_counter.increment("TT_insert_depth_improved");
-    replace = true;
-  } else if (previous_entry.type == Exact) {
-    // Now that the depths are the same, we must keep exact entries
-    perf_counter.increment("TT_insert_no_replacing_exact");
-    ASSERT_IF_MSG(type == Exact, previous_entry.value == value,
-                  "Tried to replace exact value %d with different value %d",
-                  previous_entry.value, value);
-    replace = false;
-  } else if (type == Exact) {
-    perf_counter.increment("TT_insert_new_exact");
-    replace = true;
-  } else if (type == Lower) {
-    if (previous_entry.type == Lower) {
-      replace = previous_entry.value < value;
-      if (replace)
-        perf_counter.increment("TT_insert_lower_to_lower");
-    } else if (previous_entry.type == Upper) {
-      perf_counter.increment("TT_insert_lower_to_upper");
+  // If the position is already in the bucket, decide whether the new result
+  // improves on the stored one, and overwrite it in place if so
+  for (Entry &entry : bucket.entries) {
+    const uint64_t data = entry.data.load(std::memory_order_relaxed);
+    uint64_t eval_bits;
+    if (!matches(entry, hash, data, eval_bits))
+      continue;
+    const TableEntry previous_entry = unpack(hash, data);
+    const bool eval_changed =
+        static_eval != NO_EVAL && eval_bits != new_eval_bits;
+    if (static_eval != NO_EVAL)
+      eval_bits = new_eval_bits;
+
+    bool replace = false;
+    if (previous_entry.depth > depth) {
+      // If the previous entry searched deeper, keep that one
+      perf_counter.increment("TT_insert_depth_too_low");
+      replace = false;
+    } else if (previous_entry.depth < depth) {
+      // If the new entry searched deeper, keep it
+      perf_counter.increment("TT_insert_depth_improved");
+      replace = true;
+    } else if (previous_entry.type == Exact) {
+      // Now that the depths are the same, we must keep exact entries. Another
+      // search thread may have reached this position by a different path, so
+      // the values need not agree.
+      perf_counter.increment("TT_insert_no_replacing_exact");
+      replace = false;
+    } else if (type == Exact) {
+      perf_counter.increment("TT_insert_new_exact");
       replace = true;
+    } else if (type == Lower) {
+      if (previous_entry.type == Lower) {
+        replace = previous_entry.value < value;
+        if (replace)
+          perf_counter.increment("TT_insert_lower_to_lower");
+      } else if (previous_entry.type == Upper) {
+        perf_counter.increment("TT_insert_lower_to_upper");
+        replace = true;
+      }
+    } else if (type == Upper) {
+      replace = previous_entry.type == Upper && previous_entry.value > value;
+      if (replace)
+        perf_counter.increment("TT_insert_upper_to_upper");
+    }
+
+    if (replace) {
+      perf_counter.increment("TT_insert_replace");
+      // Upper bounds have no best move, so keep the previous one for ordering
+      const uint64_t replaced_data =
+          best_move ? new_data
+                    : pack(previous_entry.best_move, depth, value, type,
+                           m_generation);
+      store(entry, hash, replaced_data, eval_bits);
+    } else if (previous_entry.generation != m_generation) {
+      // Keep the previous result, but mark it as useful to this search
+      const uint64_t refreshed_data =
+          pack(previous_entry.best_move, previous_entry.depth,
+               previous_entry.value, previous_entry.type, m_generation);
+      store(entry, hash, refreshed_data, eval_bits);
+    } else if (eval_changed) {
+      store(entry, hash, data, eval_bits);
     }
-  } else if (type == Upper) {
-    replace = previous_entry.type == Upper && previous_entry.value > value;
-    if (replace)
-      perf_counter.increment("TT_insert_upper_to_upper");
+    return;
   }
 
-  if (replace) {
-    perf_counter.increment("TT_insert_replace");
-    m_table[hash] = new_entry;
+  // Otherwise, the first entry is replaced only by results from searches at
+  // least as deep. Failing that, the always-replace entry of lowest priority
+  // makes way. Each search since an entry was stored costs it AGE_PENALTY
+  // plies of priority, so stale entries are overwritten first.
+  const auto priority = [generation = m_generation](const uint64_t data) {
+    if (data == 0)
+      return -1;
+    const TableEntry entry = unpack(0, data);
+    const int age = (uint8_t)(generation - entry.generation);
+    return entry.depth - AGE_PENALTY * age;
+  };
+  Entry *victim = &bucket.entries[0];
+  if (priority(victim->data.load(std::memory_order_relaxed)) > depth) {
+    victim = &bucket.entries[1];
+    for (size_t idx = 2; idx < BUCKET_SIZE; ++idx) {
+      Entry &entry = bucket.entries[idx];
+      if (priority(entry.data.load(std::memory_order_relaxed)) <
+          priority(victim->data.load(std::memory_order_relaxed)))
+        victim = &entry;
+    }
   }
+  perf_counter.increment("TT_insert_new");
+  store(*victim, hash, new_data, new_eval_bits);
 }
 
 std::vector<move_t> get_pv(const Board &board) {
@@ -74,7 +160,11 @@ std::vector<move_t> get_pv(const Board &board) {
     const TableEntry entry = transposition_table.query(tmp.hash());
     if (entry.type == NodeType::None || entry.best_move == 0)
       break;
+    // The table is shared and lossy, so the entry may belong to another
+    // position with the same index
     const move_t pv_move = entry.best_move;
+    if (!tmp.is_legal(pv_move))
+      break;
     tmp.make_move(pv_move);
     result.push_back(pv_move);
     if (seen.count(tmp.hash()) > 0)
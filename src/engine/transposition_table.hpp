@@ -6,12 +6,14 @@
 #include "hash.hpp"
 #include "move.hpp"
 
-#include <map>
-#include <unordered_map>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <vector>
 
-// The transposition table currently stores a mapping from position hashes, to
-// an entry containing the best move, the evaluation, the depth, the node type,
-// and the half move at which this was computed.
+// The transposition table stores a mapping from position hashes, to an entry
+// containing the best move, the evaluation, the depth, the node type, the
+// generation in which this was computed, and the position's static evaluation.
 
 // Searches can then use this information to provide better move ordering, and
 // faster evaluations
@@ -29,7 +31,8 @@ struct TableEntry {
   int depth = 0;
   int value = -SCORE_INFINITY;
   NodeType type = None;
-  int epoch = -1;
+  int generation = -1;
+  int static_eval = NO_EVAL;
 
   std::string to_string() const {
     std::stringstream result;
@@ -46,34 +49,124 @@ struct TableEntry {
   }
 };
 
-// TODO: Will probably roll my own implementation of this once things are more
-// stable
+// A fixed-size table of cache-line-sized buckets, shared by all search threads
+// without locks. Each bucket holds four 16 byte entries: the first keeps the
+// deepest result seen for its positions, and the others are always replaced.
+//
+// An entry packs a TableEntry into one 64-bit word, and stores the position's
+// hash XOR'ed with that word alongside it. Writes from two threads may tear an
+// entry, but then the XOR no longer matches any probe, so it reads as empty.
+// The static evaluation takes the bottom 16 bits of the check word, so only the
+// top 48 bits of the hash are checked: the bottom bits already chose the
+// bucket, since the table is never smaller than MIN_SIZE_MB.
+//
+// Every search starts a new generation, and entries are stamped with the
+// generation that stored them. Rather than sweeping out old entries,
+// replacement prefers to overwrite entries from earlier searches, so that
+// starting a search takes constant time.
 class TranspositionTable {
-  using Table = std::unordered_map<hash_t, TableEntry>;
-  Table m_table;
+  //   0 - 27: best move
+  //  28 - 45: value + VALUE_OFFSET
+  //  46 - 53: depth
+  //  54 - 55: node type
+  //  56 - 63: generation
+  static constexpr int VALUE_OFFSET = 1 << 17;
+  static constexpr int AGE_PENALTY = 4;
+  static constexpr uint64_t EVAL_MASK = 0xffff;
+  static constexpr uint64_t NO_EVAL_BITS = 0x8000;
+
+  struct Entry {
+    std::atomic<uint64_t> check{0}; // hash ^ data
+    std::atomic<uint64_t> data{0};
+  };
+  static constexpr size_t BUCKET_SIZE = 4;
+  struct alignas(64) Bucket {
+    Entry entries[BUCKET_SIZE];
+  };
+  static_assert(sizeof(Bucket) == 64);
+
+  std::vector<Bucket> m_buckets;
+  uint8_t m_generation = 0;
+
+  static constexpr inline uint64_t pack(const move_t best_move, const int depth,
+                                        const int value, const NodeType type,
+                                        const int generation) {
+    return (uint64_t)(best_move & 0xfffffff) |
+           ((uint64_t)(value + VALUE_OFFSET) & 0x3ffff) << 28 |
+           ((uint64_t)depth & 0xff) << 46 | ((uint64_t)type & 0x3) << 54 |
+           ((uint64_t)generation & 0xff) << 56;
+  }
+  static constexpr inline TableEntry unpack(const hash_t hash,
+                                            const uint64_t data) {
+    return {hash,
+            (move_t)(data & 0xfffffff),
+            (int)((data >> 46) & 0xff),
+            (int)((data >> 28) & 0x3ffff) - VALUE_OFFSET,
+            (NodeType)((data >> 54) & 0x3),
+            (int)(data >> 56)};
+  }
+
+  // The static evaluation as a 16 bit two's complement number, saturating
+  static constexpr inline uint64_t pack_eval(const int static_eval) {
+    if (static_eval == NO_EVAL)
+      return NO_EVAL_BITS;
+    return (uint64_t)(uint16_t)(int16_t)std::clamp(static_eval, -32767, 32767);
+  }
+  static constexpr inline int unpack_eval(const uint64_t bits) {
+    return (bits == NO_EVAL_BITS) ? (int)NO_EVAL : (int)(int16_t)(uint16_t)bits;
+  }
+  // The static evaluation bits of the entry, if it holds the given position
+  static inline bool matches(const Entry &entry, const hash_t hash,
+                             const uint64_t data, uint64_t &eval_bits) {
+    const uint64_t key = entry.check.load(std::memory_order_relaxed) ^ data;
+    eval_bits = (key ^ hash) & EVAL_MASK;
+    return ((key ^ hash) & ~EVAL_MASK) == 0 && data != 0;
+  }
+  static inline void store(Entry &entry, const hash_t hash, const uint64_t data,
+                           const uint64_t eval_bits) {
+    entry.check.store(hash ^ data ^ eval_bits, std::memory_order_relaxed);
+    entry.data.store(data, std::memory_order_relaxed);
+  }
+
+  Bucket &bucket(const hash_t hash) noexcept {
+    return m_buckets[hash & (m_buckets.size() - 1)];
+  }
+  const Bucket &bucket(const hash_t hash) const noexcept {
+    return m_buckets[hash & (m_buckets.size() - 1)];
+  }
 
 public:
-  void clear() noexcept { m_table.clear(); }
-  size_t size() const noexcept { return m_table.size(); }
+  // 4 MB holds 2^16 buckets, so the bucket index covers the 16 hash bits that
+  // entries don't check
+  static constexpr int MIN_SIZE_MB = 4;
+
+  explicit TranspositionTable(const size_t size_mb = 16) { resize(size_mb); }
+
+  // Reallocates the table with the largest power-of-two number of buckets that
+  // fits in size_mb megabytes, but no fewer than MIN_SIZE_MB, discarding every
+  // entry
+  void resize(const size_t size_mb);
+  void clear() noexcept;
+  // The number of entries per thousand stored by the current search, estimated
+  // from the first thousand entries, as reported by UCI's hashfull
+  int hashfull() const noexcept;
+  size_t capacity() const noexcept { return m_buckets.size() * BUCKET_SIZE; }
+  size_t size_in_bytes() const noexcept {
+    return m_buckets.size() * sizeof(Bucket);
+  }
+  size_t size_in_mb() const noexcept { return size_in_bytes() >> 20; }
+
   TableEntry query(const hash_t hash) const;
+  // Without a static evaluation, a stored one for the position is kept
   void insert(const Board &board, const move_t best_move, const int depth,
-              const int value, const NodeType type);
-  void clear_for_search(const Board &board) {
-    const int epoch = board.fifty_move_monovariant();
-    std::cout << "info string clearing ttable for search..." << std::endl;
-    std::cout << "info string removing entries with epoch less than " << epoch
-              << std::endl;
-    const size_t removed_count =
-        std::erase_if(m_table, [epoch](const auto &item) {
-          return item.second.epoch < epoch;
-        });
-    std::cout << "info string removed " << removed_count << " expired entries"
-              << std::endl;
-  }
+              const int value, const NodeType type,
+              const int static_eval = NO_EVAL);
+  // Starts a new generation: entries from earlier searches are kept, but are
+  // replaced before entries from this one
+  void new_search() noexcept { m_generation++; }
 };
 
 std::vector<move_t> get_pv(const Board &board);
 std::string get_pv_string(const Board &board);
 
 extern TranspositionTable transposition_table;
-extern TranspositionTable quiescence_table;
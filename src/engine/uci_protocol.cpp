@@ -3,7 +3,9 @@
 #include "board.hpp"
 #include "evaluate.hpp"
 #include "move.hpp"
+#include "perft.hpp"
 #include "search_info.hpp"
+#include "search_params.hpp"
 #include "transposition_table.hpp"
 #include "util.hpp"
 
@@ -17,11 +19,13 @@
 std::vector<SearchThread> search_threads;
 std::mutex search_threads_mutex;
 
-SearchThread::SearchThread(const Board &board, const float seconds_to_search,
-                           const int depth, const bool infinite,
-                           const bool send_info)
-    : m_board(board), m_info(std::make_unique<SearchInfo>(
-                          seconds_to_search, depth, infinite, send_info)) {
+SearchThread::SearchThread(const Board &board,
+                           const TimeManager &time_manager, const int depth,
+                           const bool infinite, const bool send_info,
+                           const int num_threads)
+    : m_board(board),
+      m_info(std::make_unique<SearchInfo>(time_manager, depth, infinite,
+                                          send_info, num_threads)) {
   m_thread = std::thread([&]() {
     search(*m_info, m_board);
     std::thread(remove_thread, m_thread.get_id()).detach();
@@ -41,7 +45,7 @@ void remove_thread(const std::thread::id id) {
 
 void ponder(const Board &board) {
   std::lock_guard<std::mutex> guard(search_threads_mutex);
-  search_threads.emplace_back(board, 0, 100, true, false);
+  search_threads.emplace_back(board, TimeManager(), 100, true, false);
 }
 
 void stop_all() {
@@ -53,6 +57,8 @@ void stop_all() {
 
 namespace UCIProtocol {
 
+int num_threads = 1;
+
 void send_info(const std::string &str) {
   std::cout << "info string " << str << std::endl;
 }
@@ -60,9 +66,31 @@ void send_info(const std::string &str) {
 void send_identity() {
   std::cout << "id name magnum_carl" << std::endl;
   std::cout << "id author nathanlo99" << std::endl;
+  std::cout << "option name Hash type spin default 16 min "
+            << TranspositionTable::MIN_SIZE_MB << " max 65536" << std::endl;
+  std::cout << "option name Clear Hash type button" << std::endl;
+  std::cout << "option name Threads type spin default 1 min 1 max 256"
+            << std::endl;
+  for (const TunableParameter &param : tunable_parameters) {
+    std::cout << "option name " << param.name << " type spin default "
+              << *param.value << " min " << param.min << " max " << param.max
+              << std::endl;
+  }
   std::cout << "uciok" << std::endl;
 }
 
+// go perft 5
+// Prints the perft count below each legal move, in the same format as other
+// engines' perft divides, followed by the total
+void process_perft_command(const int depth, const Board &board) {
+  size_t total = 0;
+  for (const auto &[move, count] : perft_divide(board, depth)) {
+    std::cout << simple_string_from_move(move) << ": " << count << std::endl;
+    total += count;
+  }
+  std::cout << std::endl << "Nodes searched: " << total << std::endl;
+}
+
 // go depth 6 wtime 180000 time 180000 binc 1000 winc 1000 movetime 1000
 // movestogo 40
 void process_go_command(const std::vector<std::string> &tokens,
@@ -126,14 +154,56 @@ void process_go_command(const std::vector<std::string> &tokens,
   std::lock_guard<std::mutex> guard(search_threads_mutex);
   if (move_time != -1) {
     // If the go command provides a search time, just run with that
-    search_threads.emplace_back(board, move_time / 1000.0, depth, false, true);
+    search_threads.emplace_back(board, TimeManager::fixed(move_time / 1000.0),
+                                depth, false, true, num_threads);
   } else if (remaining_time != -1) {
-    const int move_time_in_ms = (remaining_time - 5000) / moves_to_go;
-    float seconds_to_search = (move_time_in_ms + increment / 2) / 1000.0;
-    seconds_to_search = std::max(0.05f, seconds_to_search - 0.03f);
-    search_threads.emplace_back(board, seconds_to_search, depth, false, true);
+    search_threads.emplace_back(
+        board, TimeManager::from_clock(remaining_time, increment, moves_to_go),
+        depth, false, true, num_threads);
   } else {
-    search_threads.emplace_back(board, 0, depth, true, true);
+    search_threads.emplace_back(board, TimeManager(), depth, true, true,
+                                num_threads);
+  }
+}
+
+// setoption name Threads value 8
+// setoption name Hash value 256
+// setoption name Clear Hash
+// setoption name LMRDivisor value 200
+void process_setoption_command(const std::vector<std::string> &tokens) {
+  const auto name_it = std::find(tokens.begin(), tokens.end(), "name");
+  const auto value_it = std::find(tokens.begin(), tokens.end(), "value");
+  if (name_it == tokens.end())
+    return;
+  // Option names may contain spaces, and run until the value (if any)
+  std::string name;
+  for (auto it = name_it + 1; it != value_it; ++it)
+    name += (name.empty() ? "" : " ") + *it;
+  const std::string value =
+      (value_it != tokens.end() && value_it + 1 != tokens.end())
+          ? *(value_it + 1)
+          : "";
+
+  if (name == "Hash" && !value.empty()) {
+    transposition_table.resize(std::clamp(
+        std::stoi(value), TranspositionTable::MIN_SIZE_MB, 65536));
+    send_info("Resized hash to " +
+              std::to_string(transposition_table.size_in_mb()) + " MB (" +
+              std::to_string(transposition_table.capacity()) + " entries)");
+  } else if (name == "Clear Hash") {
+    transposition_table.clear();
+    send_info("Cleared hash");
+  } else if (name == "Threads" && !value.empty()) {
+    num_threads = std::clamp(std::stoi(value), 1, 256);
+    send_info("Searching with " + std::to_string(num_threads) + " threads");
+  } else if (!value.empty()) {
+    for (const TunableParameter &param : tunable_parameters) {
+      if (name != param.name)
+        continue;
+      *param.value = std::clamp(std::stoi(value), param.min, param.max);
+      init_search_params();
+      send_info("Set " + param.name + " to " + std::to_string(*param.value));
+    }
   }
 }
 
@@ -184,11 +254,29 @@ void start_loop() {
     } else if (tokens[0] == "position") {
       board = parse_position_command(line);
 
+    } else if (tokens[0] == "setoption") {
+      stop_all();
+      process_setoption_command(tokens);
+
     } else if (tokens[0] == "ucinewgame") {
       board = Board();
 
     } else if (tokens[0] == "go") {
       stop_all();
+      if (tokens.size() > 1 && tokens[1] == "perft") {
+        // A depth below 1 has no moves to divide, and anything but digits
+        // would make std::stoi throw
+        const bool valid_depth =
+            tokens.size() > 2 && !tokens[2].empty() && tokens[2].size() <= 3 &&
+            std::all_of(tokens[2].begin(), tokens[2].end(),
+                        [](const char c) { return '0' <= c && c <= '9'; }) &&
+            std::stoi(tokens[2]) >= 1;
+        if (valid_depth)
+          process_perft_command(std::stoi(tokens[2]), board);
+        else
+          send_info("Usage: go perft <depth>, with depth at least 1");
+        continue;
+      }
       process_go_command(tokens, board); // Spawns a search thread
       std::lock_guard<std::mutex> guard(search_threads_mutex);
       send_info("There are " + std::to_string(search_threads.size()) +
@@ -15,8 +15,9 @@ struct SearchThread {
   std::unique_ptr<SearchInfo> m_info;
   std::thread m_thread;
 
-  SearchThread(const Board &board, const float seconds_to_search,
-               const int depth, const bool infinite, const bool send_info);
+  SearchThread(const Board &board, const TimeManager &time_manager,
+               const int depth, const bool infinite, const bool send_info,
+               const int num_threads = 1);
 
   inline void stop() {
     if (m_info)
@@ -35,11 +36,16 @@ void remove_thread(const std::thread::id id);
 
 namespace UCIProtocol {
 
+// The number of threads each search uses, set by the Threads option
+extern int num_threads;
+
 void send_info(const std::string &str);
 void send_identity();
+void process_perft_command(const int depth, const Board &board);
 void process_go_command(const std::vector<std::string> &tokens,
                         const Board &board);
 Board parse_position_command(const std::string &line);
+void process_setoption_command(const std::vector<std::string> &tokens);
 void start_loop();
 
 }; // namespace UCIProtocol
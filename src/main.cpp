@@ -7,6 +7,7 @@
 #include "../tests/runtests.hpp"
 
 #include "assert.hpp"
+#include "bitboard.hpp"
 #include "board.hpp"
 #include "evaluate.hpp"
 #include "hash.hpp"
@@ -14,6 +15,7 @@
 #include "opening_book.hpp"
 #include "perf_counter.hpp"
 #include "piece_values.hpp"
+#include "search_params.hpp"
 #include "simulate.hpp"
 #include "transposition_table.hpp"
 #include "uci_protocol.hpp"
@@ -50,8 +52,10 @@ void test_position(const std::string &fen) {
 
 int main(int argc, char *argv[]) {
   // std::cout << "Initializing playchess..." << std::endl;
+  init_bitboards();
   init_hash();
   init_piece_values();
+  init_search_params();
 
   const auto book_ns = timeit(
       [&] { opening_book.read_book("references/book/opening_book.txt"); });
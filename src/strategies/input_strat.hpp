@@ -4,13 +4,11 @@
 #include "strategy.hpp"
 #include <iostream>
 #include <string>
-#include <vector>
 
 class InputStrategy : Strategy {
 public:
   void init(const Board &board) override {}
-  move_t make_move(const Board &board,
-                   const std::vector<move_t> &move_list) override {
+  move_t make_move(const Board &board, const MoveList &move_list) override {
     std::cout << board.to_string(board.m_side_to_move) << std::endl;
     std::string input;
     std::cout << "Enter a move: " << std::flush;
@@ -6,7 +6,6 @@
 #include "move.hpp"
 #include "strategy.hpp"
 
-#include <vector>
 
 class SearchStrategy : Strategy {
   const bool m_use_book;
@@ -17,8 +16,7 @@ public:
   SearchStrategy(const bool use_book, const int depth, const float max_seconds)
       : m_use_book(use_book), m_depth(depth), m_seconds(max_seconds) {}
   void init(const Board &board) override {}
-  move_t make_move(const Board &board,
-                   const std::vector<move_t> &move_list) override {
+  move_t make_move(const Board &board, const MoveList &move_list) override {
     if (m_use_book) {
       const move_t book_move = opening_book.query(board, 10);
       if (book_move != 0)
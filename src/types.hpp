@@ -3,7 +3,9 @@
 
 #include <cstdint>
 
+using bitboard_t = uint64_t;
 using castle_t = uint8_t;
 using hash_t = uint64_t;
 using move_t = uint32_t;
 using piece_t = uint8_t;
+using score_t = int32_t;
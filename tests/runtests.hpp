@@ -1,10 +1,15 @@
 
 #pragma once
 
+#include "test_attack_map.hpp"
+#include "test_bitboards.hpp"
 #include "test_board.hpp"
+#include "test_move_picker.hpp"
+#include "test_pawn_structure.hpp"
 #include "test_perft.hpp"
 #include "test_pieces.hpp"
 #include "test_search.hpp"
+#include "test_see.hpp"
 #include "test_squares.hpp"
 
 int run_tests(const std::string &perft_file, const int perft_depth) {
@@ -12,6 +17,11 @@ int run_tests(const std::string &perft_file, const int perft_depth) {
   fail_flag |= test_pieces();
   fail_flag |= test_squares();
   fail_flag |= test_board();
+  fail_flag |= test_bitboards();
+  fail_flag |= test_attack_map();
+  fail_flag |= test_move_picker();
+  fail_flag |= test_see();
+  fail_flag |= test_pawn_structure();
   fail_flag |= test_perft(perft_file, perft_depth);
   return fail_flag;
 }
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <string>
+
+#include "assert.hpp"
+#include "attack_map.hpp"
+#include "board.hpp"
+#include "evaluate.hpp"
+#include "piece_values.hpp"
+#include "square.hpp"
+#include "test_board.hpp"
+
+// Checks the attack map's tallies against ones built square by square from
+// attackers_to
+inline int test_attack_map_tallies(const Board &board) {
+  [[maybe_unused]] const AttackMap attacks(board);
+  const bitboard_t occ = board.occupied();
+  for (const int side : {WHITE, BLACK}) {
+    const piece_t offset = (side == WHITE) ? 0 : 8;
+    const bitboard_t enemy_pawns =
+        board.pieces((side == WHITE) ? BLACK_PAWN : WHITE_PAWN);
+
+    // Count the squares each piece attacks, which are neither occupied by its
+    // own side nor attacked by an enemy pawn
+    int num_squares[64] = {};
+    for (int sq64 = 0; sq64 < 64; ++sq64) {
+      if ((board.side_pieces(side) & square_bb(sq64)) ||
+          (board.attackers_to(sq64, !side, occ) & enemy_pawns))
+        continue;
+      bitboard_t attackers = board.attackers_to(sq64, side, occ);
+      while (attackers)
+        num_squares[pop_lsb(attackers)]++;
+    }
+    [[maybe_unused]] score_t mobility = 0;
+    for (const piece_t piece : {WHITE_KNIGHT, WHITE_BISHOP, WHITE_ROOK,
+                                WHITE_QUEEN}) {
+      bitboard_t pieces = board.pieces(piece | offset);
+      while (pieces) {
+        const int sq64 = pop_lsb(pieces);
+        mobility += mobility_score(piece, num_squares[sq64]);
+      }
+    }
+    ASSERT_MSG(attacks.mobility[side] == mobility,
+               "Mobility of side %d is (%d, %d), not (%d, %d) in %s", side,
+               middlegame_value(attacks.mobility[side]),
+               endgame_value(attacks.mobility[side]),
+               middlegame_value(mobility), endgame_value(mobility),
+               board.fen().c_str());
+
+    // Every piece attacking a square next to the enemy king, besides pawns
+    // and the king itself
+    const bitboard_t zone = king_zone(
+        lsb(board.pieces((side == WHITE) ? BLACK_KING : WHITE_KING)));
+    bitboard_t attackers = 0;
+    for (int sq64 = 0; sq64 < 64; ++sq64) {
+      if (zone & square_bb(sq64))
+        attackers |= board.attackers_to(sq64, side, occ);
+    }
+    attackers &= ~board.pieces(WHITE_PAWN | offset) &
+                 ~board.pieces(WHITE_KING | offset);
+    [[maybe_unused]] const int num_attackers = popcount(attackers);
+    [[maybe_unused]] int weight = 0;
+    while (attackers) {
+      const int sq64 = pop_lsb(attackers);
+      weight += king_attack_weights[board.piece_at(
+          get_square_120_rc(sq64 / 8, sq64 % 8))];
+    }
+    ASSERT_MSG(attacks.king_attackers[side] == num_attackers &&
+                   attacks.king_attack_weight[side] == weight,
+               "King attacks of side %d are %d with weight %d, not %d with "
+               "weight %d in %s",
+               side, attacks.king_attackers[side],
+               attacks.king_attack_weight[side], num_attackers, weight,
+               board.fen().c_str());
+  }
+  return 0;
+}
+
+// The piece terms besides mobility, which the following positions are built
+// to isolate
+inline score_t piece_terms_of(const std::string &fen) {
+  const Board board(fen);
+  const AttackMap attacks(board);
+  return evaluate_pieces(board) - attacks.mobility[WHITE] +
+         attacks.mobility[BLACK];
+}
+
+// Checks that the first position's piece terms are better for white than the
+// second's, in both phases
+inline int test_piece_terms_better(const std::string &better_fen,
+                                   const std::string &worse_fen) {
+  [[maybe_unused]] const score_t better = piece_terms_of(better_fen);
+  [[maybe_unused]] const score_t worse = piece_terms_of(worse_fen);
+  ASSERT_MSG(middlegame_value(better) > middlegame_value(worse) &&
+                 endgame_value(better) > endgame_value(worse),
+             "Piece terms of %s (%d, %d) are not better than %s (%d, %d)",
+             better_fen.c_str(), middlegame_value(better),
+             endgame_value(better), worse_fen.c_str(), middlegame_value(worse),
+             endgame_value(worse));
+  return 0;
+}
+
+inline int test_attack_map() {
+  int fail_flag = 0;
+  // The attack maps agree with square_attacked on every square
+  for (const auto &fen : testFENs) {
+    const Board board(fen);
+    [[maybe_unused]] const AttackMap attacks(board);
+    for (int sq64 = 0; sq64 < 64; ++sq64) {
+      [[maybe_unused]] const square_t sq =
+          get_square_120_rc(sq64 / 8, sq64 % 8);
+      for ([[maybe_unused]] const int side : {WHITE, BLACK}) {
+        ASSERT_MSG(attacks.attacks(side, sq64) ==
+                       board.square_attacked(sq, side),
+                   "Attack map of side %d disagrees on %s in %s", side,
+                   string_from_square(sq).c_str(), fen.c_str());
+      }
+    }
+    fail_flag |= test_attack_map_tallies(board);
+  }
+
+  // A king next to the enemy king is not an attacker, so a lone knight with
+  // its king's help doesn't count as two
+  fail_flag |= test_attack_map_tallies(Board("8/8/8/8/8/3kNK2/8/8 w - - 0 1"));
+
+  // The bishop pair, against a bishop and a knight
+  fail_flag |= test_piece_terms_better("4k3/8/8/8/8/8/8/2B1KB2 w - - 0 1",
+                                       "4k3/8/8/8/8/8/8/2B1KN2 w - - 0 1");
+  // A rook on an open file, against one behind its own pawn
+  fail_flag |= test_piece_terms_better("4k3/1p6/8/8/8/8/1P6/R3K3 w - - 0 1",
+                                       "4k3/1p6/8/8/8/8/P7/R3K3 w - - 0 1");
+  return fail_flag;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <string>
+
+#include "assert.hpp"
+#include "bitboard.hpp"
+#include "board.hpp"
+#include "test_board.hpp"
+
+// Walks the 120-square board from sq along each offset until it falls off the
+// board or hits an occupied square, as the mailbox move generator used to
+inline bitboard_t slow_slider_attacks(const Board &board, const square_t sq,
+                                      std::initializer_list<int> offsets) {
+  bitboard_t result = 0;
+  for (const int offset : offsets) {
+    square_t cur_square = sq + offset;
+    while (valid_square(cur_square)) {
+      result |= square_bb_120(cur_square);
+      if (board.piece_at(cur_square) != INVALID_PIECE)
+        break;
+      cur_square += offset;
+    }
+  }
+  return result;
+}
+
+inline int test_bitboard_fen(const std::string &fen) {
+  const Board board(fen);
+  const bitboard_t occ = board.occupied();
+  for (int row = 0; row < 8; ++row) {
+    for (int col = 0; col < 8; ++col) {
+      const square_t sq = get_square_120_rc(row, col);
+      const int sq64 = get_square_64(sq);
+      const piece_t piece = board.piece_at(sq);
+      ASSERT_MSG(((occ >> sq64) & 1) == (piece != INVALID_PIECE),
+                 "Occupancy of %s disagrees with the mailbox in %s",
+                 string_from_square(sq).c_str(), fen.c_str());
+      ASSERT_IF_MSG(piece != INVALID_PIECE,
+                    board.pieces(piece) & square_bb(sq64),
+                    "Bitboard of piece %u is missing %s in %s", piece,
+                    string_from_square(sq).c_str(), fen.c_str());
+      ASSERT_MSG(bishop_attacks(sq64, occ) ==
+                     slow_slider_attacks(board, sq, {-11, -9, 9, 11}),
+                 "Bishop attacks from %s are wrong in %s",
+                 string_from_square(sq).c_str(), fen.c_str());
+      ASSERT_MSG(rook_attacks(sq64, occ) ==
+                     slow_slider_attacks(board, sq, {-10, -1, 1, 10}),
+                 "Rook attacks from %s are wrong in %s",
+                 string_from_square(sq).c_str(), fen.c_str());
+    }
+  }
+  return 0;
+}
+
+inline int test_bitboards() {
+  int fail_flag = 0;
+  ASSERT(popcount(knight_attacks[get_square_64(A1)]) == 2);
+  ASSERT(popcount(knight_attacks[get_square_64(D4)]) == 8);
+  ASSERT(popcount(king_attacks[get_square_64(H8)]) == 3);
+  ASSERT(pawn_attacks[WHITE][get_square_64(E4)] ==
+         (square_bb_120(D5) | square_bb_120(F5)));
+  ASSERT(pawn_attacks[BLACK][get_square_64(A5)] == square_bb_120(B4));
+  for (const auto &fen : testFENs) {
+    fail_flag |= test_bitboard_fen(fen);
+  }
+  return fail_flag;
+}
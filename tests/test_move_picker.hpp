@@ -0,0 +1,131 @@
+#pragma once
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "assert.hpp"
+#include "board.hpp"
+#include "move.hpp"
+#include "move_picker.hpp"
+#include "test_board.hpp"
+
+inline std::vector<move_t> sorted_moves(std::vector<move_t> moves) {
+  std::sort(moves.begin(), moves.end());
+  return moves;
+}
+
+// Checks that the tactical and quiet moves split all the moves between them,
+// for both generators
+inline int test_move_gen_types(const Board &board) {
+  for (const bool legal : {true, false}) {
+    const auto generate = [&](const MoveGenType type) {
+      const MoveList moves =
+          legal ? board.legal_moves(type) : board.pseudo_moves(type);
+      return std::vector<move_t>(moves.begin(), moves.end());
+    };
+    const std::vector<move_t> tactical = generate(TACTICAL_MOVES);
+    const std::vector<move_t> quiet = generate(QUIET_MOVES);
+    std::vector<move_t> both = tactical;
+    both.insert(both.end(), quiet.begin(), quiet.end());
+    ASSERT_MSG(sorted_moves(both) == sorted_moves(generate(ALL_MOVES)),
+               "Tactical and quiet %s moves don't make up all of them in %s",
+               legal ? "legal" : "pseudo-legal", board.fen().c_str());
+    ASSERT_MSG(std::all_of(tactical.begin(), tactical.end(), is_tactical) &&
+                   std::none_of(quiet.begin(), quiet.end(), is_tactical),
+               "Tactical and quiet %s moves are mixed up in %s",
+               legal ? "legal" : "pseudo-legal", board.fen().c_str());
+  }
+  return 0;
+}
+
+// Checks that the picker yields exactly the legal moves of the position, each
+// once, whatever TT move and killers it is given
+inline int test_move_picker_moves(const Board &board, const move_t tt_move,
+                                  const std::array<move_t, 2> &killers,
+                                  const bool generate_quiet_moves) {
+  std::vector<move_t> expected;
+  for (const move_t move :
+       board.legal_moves(generate_quiet_moves ? ALL_MOVES : TACTICAL_MOVES))
+    expected.push_back(move);
+
+  std::vector<move_t> actual;
+  MovePicker picker(board, tt_move, killers, generate_quiet_moves);
+  for (move_t move = picker.next(); move; move = picker.next())
+    actual.push_back(move);
+  ASSERT_MSG(picker.stage() == MovePicker::DONE,
+             "Move picker did not finish in %s", board.fen().c_str());
+  ASSERT_MSG(sorted_moves(actual) == sorted_moves(expected),
+             "Move picker yielded %lu moves instead of %lu in %s",
+             actual.size(), expected.size(), board.fen().c_str());
+
+  if (!generate_quiet_moves) {
+    // Quiescence search may ask for the quiet checks as well
+    Board copy = board;
+    for (const move_t move : board.legal_moves(QUIET_MOVES)) {
+      copy.make_move(move);
+      if (copy.king_in_check())
+        expected.push_back(move);
+      copy.unmake_move();
+    }
+    std::vector<move_t> checks_actual;
+    MovePicker checks_picker(board, tt_move, killers, false, true);
+    for (move_t move = checks_picker.next(); move; move = checks_picker.next())
+      checks_actual.push_back(move);
+    ASSERT_MSG(sorted_moves(checks_actual) == sorted_moves(expected),
+               "Move picker with quiet checks yielded %lu moves instead of "
+               "%lu in %s",
+               checks_actual.size(), expected.size(), board.fen().c_str());
+  } else {
+    MoveHistory history;
+    history.killers[0] = killers;
+    for (const move_t move : expected)
+      history.update(board, 1, 3, move, {});
+    std::vector<move_t> history_actual;
+    MovePicker history_picker(board, tt_move, history, 0);
+    for (move_t move = history_picker.next(); move;
+         move = history_picker.next())
+      history_actual.push_back(move);
+    ASSERT_MSG(sorted_moves(history_actual) == sorted_moves(expected),
+               "Move picker with history yielded %lu moves instead of %lu in "
+               "%s",
+               history_actual.size(), expected.size(), board.fen().c_str());
+  }
+  ASSERT_IF_MSG(board.is_legal(tt_move) &&
+                    (generate_quiet_moves || is_tactical(tt_move)),
+                actual[0] == tt_move,
+                "Move picker did not start with the TT move %s in %s",
+                string_from_move(tt_move).c_str(), board.fen().c_str());
+  return 0;
+}
+
+inline int test_move_picker() {
+  int fail_flag = 0;
+  // Every position's moves serve as (mostly illegal) TT moves and killers for
+  // every other position
+  std::vector<move_t> candidates;
+  for (const auto &fen : testFENs) {
+    for (const move_t move : Board(fen).legal_moves())
+      candidates.push_back(move);
+  }
+
+  for (const auto &fen : testFENs) {
+    const Board board(fen);
+    [[maybe_unused]] const MoveList legal_moves = board.legal_moves();
+    for (const move_t move : candidates) {
+      ASSERT_MSG(board.is_legal(move) == legal_moves.contains(move),
+                 "is_legal(%s) is wrong in %s", string_from_move(move).c_str(),
+                 fen.c_str());
+    }
+    fail_flag |= test_move_gen_types(board);
+
+    for (size_t idx = 0; idx < candidates.size(); ++idx) {
+      const std::array<move_t, 2> killers = {
+          candidates[(idx + 1) % candidates.size()],
+          candidates[(idx + 7) % candidates.size()]};
+      fail_flag |= test_move_picker_moves(board, candidates[idx], killers, true);
+      fail_flag |= test_move_picker_moves(board, candidates[idx], {}, false);
+    }
+  }
+  return fail_flag;
+}
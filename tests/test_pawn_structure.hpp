@@ -0,0 +1,70 @@
+#pragma once
+
+#include <string>
+
+#include "assert.hpp"
+#include "board.hpp"
+#include "pawn_structure.hpp"
+#include "piece_values.hpp"
+#include "test_board.hpp"
+
+inline score_t pawn_structure_of(const std::string &fen) {
+  const Board board(fen);
+  return evaluate_pawn_structure(board.pieces(WHITE_PAWN),
+                                 board.pieces(BLACK_PAWN));
+}
+
+// Checks that the first position's pawn structure is better for white than
+// the second's, in both phases
+inline int test_pawn_structure_better(const std::string &better_fen,
+                                      const std::string &worse_fen) {
+  [[maybe_unused]] const score_t better = pawn_structure_of(better_fen);
+  [[maybe_unused]] const score_t worse = pawn_structure_of(worse_fen);
+  ASSERT_MSG(middlegame_value(better) > middlegame_value(worse) &&
+                 endgame_value(better) > endgame_value(worse),
+             "Pawn structure of %s (%d, %d) is not better than %s (%d, %d)",
+             better_fen.c_str(), middlegame_value(better),
+             endgame_value(better), worse_fen.c_str(), middlegame_value(worse),
+             endgame_value(worse));
+  return 0;
+}
+
+inline int test_pawn_structure() {
+  int fail_flag = 0;
+  // Swapping the colours of every pawn and mirroring the board negates the
+  // score, and the pawn table agrees with computing it directly
+  PawnTable pawn_table;
+  for (const auto &fen : testFENs) {
+    const Board board(fen);
+    [[maybe_unused]] const score_t score = evaluate_pawn_structure(
+        board.pieces(WHITE_PAWN), board.pieces(BLACK_PAWN));
+    [[maybe_unused]] const score_t mirrored =
+        evaluate_pawn_structure(__builtin_bswap64(board.pieces(BLACK_PAWN)),
+                                __builtin_bswap64(board.pieces(WHITE_PAWN)));
+    ASSERT_MSG(score == -mirrored,
+               "Pawn structure of %s is not symmetric", fen.c_str());
+    ASSERT_MSG(pawn_table.probe(board) == score &&
+                   pawn_table.probe(board) == score,
+               "Pawn table disagrees on %s", fen.c_str());
+  }
+
+  // Passed pawns are worth more the further they are advanced
+  fail_flag |= test_pawn_structure_better("4k3/8/4P3/8/8/8/8/4K3 w - - 0 1",
+                                          "4k3/8/8/4P3/8/8/8/4K3 w - - 0 1");
+  // A blocked pawn is not passed
+  fail_flag |= test_pawn_structure_better("4k3/8/8/4P3/8/8/8/4K3 w - - 0 1",
+                                          "4k3/8/4p3/4P3/8/8/8/4K3 w - - 0 1");
+  // Doubled pawns
+  fail_flag |=
+      test_pawn_structure_better("4k3/pp6/8/8/8/8/PP6/4K3 w - - 0 1",
+                                 "4k3/pp6/8/8/8/P7/P7/4K3 w - - 0 1");
+  // Isolated pawns
+  fail_flag |=
+      test_pawn_structure_better("4k3/p1p5/8/8/8/8/PP6/4K3 w - - 0 1",
+                                 "4k3/p1p5/8/8/8/8/P1P5/4K3 w - - 0 1");
+  // A backward pawn, whose advance is covered by an enemy pawn
+  fail_flag |=
+      test_pawn_structure_better("4k3/8/8/3p4/1PP5/8/8/4K3 w - - 0 1",
+                                 "4k3/8/8/3p4/1P6/2P5/8/4K3 w - - 0 1");
+  return fail_flag;
+}
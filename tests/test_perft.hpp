@@ -2,14 +2,13 @@
 #pragma once
 
 #include "move.hpp"
+#include "perft.hpp"
 #include "test_util.hpp"
 #include "timeit.hpp"
 
-#include <cstdlib>
 #include <fstream>
 #include <iostream>
 #include <map>
-#include <set>
 #include <sstream>
 #include <string>
 #include <utility>
@@ -47,94 +46,123 @@ load_perft(const std::string &file_name = "tests/perft.txt") {
   return result;
 }
 
-size_t do_perft(Board &board, const int depth) {
-  if (depth == 0)
-    return 1;
-  size_t result = 0;
-  for (const move_t move : board.pseudo_moves()) {
-    if (board.make_move(move))
-      result += do_perft(board, depth - 1);
-    board.unmake_move();
-  }
+// Expected perft counts keyed by (FEN, depth), and expected per-move counts
+// (perft divides) keyed the same way. FENs are normalized through Board so that
+// they match board.fen() during the divide.
+using perft_totals_t = std::map<std::pair<std::string, int>, size_t>;
+using perft_divides_t =
+    std::map<std::pair<std::string, int>, std::map<std::string, size_t>>;
+
+static perft_totals_t perft_totals(const std::vector<perft_t> &tests) {
+  perft_totals_t result;
+  for (const auto &perft : tests)
+    result[{Board(perft.fen).fen(), perft.depth}] = perft.expected;
   return result;
 }
 
-std::string exec(const std::string &cmd) {
-  std::array<char, 256> buffer;
-  std::stringstream result;
-  std::unique_ptr<FILE, decltype(&pclose)> pipe(popen(cmd.c_str(), "r"),
-                                                pclose);
-  if (!pipe)
-    throw std::runtime_error("popen() failed!");
-  while (fgets(buffer.data(), buffer.size(), pipe.get()) != nullptr)
-    result << buffer.data();
-  return result.str();
-}
-
-std::map<std::string, size_t> get_stockfish_perft(const std::string &fen,
-                                                  const int depth) {
-  std::stringstream cmd;
-  cmd << "echo \"position fen " << fen << "\\n"
-      << "go perft " << depth << "\" | references/Stockfish/src/stockfish";
-  std::stringstream out(exec(cmd.str()));
-
-  std::map<std::string, size_t> expected;
+// Each line of a divide file is "<fen>; <depth>; <move>; <count>", where count
+// is the perft count at depth - 1 after making the move
+static perft_divides_t load_perft_divides(const std::string &file_name) {
+  perft_divides_t result;
+  std::ifstream file{file_name};
   std::string line;
-  while (std::getline(out, line)) {
-    if (line.size() < 4)
-      continue;
-    if (line[4] == ':')
-      expected[line.substr(0, 4)] = std::stol(line.substr(6));
-    if (line[5] == ':')
-      expected[line.substr(0, 5)] = std::stol(line.substr(7));
+  while (std::getline(file, line)) {
+    const std::vector<std::string> tokens = split(line, "; ");
+    if (tokens.size() != 4)
+      throw "Invalid perft divide format!";
+    const std::string fen = Board(tokens[0]).fen();
+    const int depth = std::stoi(tokens[1]);
+    result[{fen, depth}][tokens[2]] = std::stol(tokens[3]);
   }
-  return expected;
+  return result;
 }
 
-void do_perft_div(Board &board, const int depth) {
+// Narrows a perft mismatch down to a single position and move: first to the
+// shallowest depth whose known total is wrong, then into the first root move
+// whose count differs from the expected divide
+void do_perft_div(const Board &board, int depth, const perft_totals_t &totals,
+                  const perft_divides_t &divides,
+                  PerftTable *table = nullptr) {
+  const std::string fen = board.fen();
+  for (int shallow_depth = 1; shallow_depth < depth; ++shallow_depth) {
+    const auto it = totals.find({fen, shallow_depth});
+    if (it != totals.end() &&
+        parallel_perft(board, shallow_depth, table) != it->second) {
+      depth = shallow_depth;
+      break;
+    }
+  }
+
   std::cout << "Starting perft divide with FEN:" << std::endl;
-  std::cout << "\t" << board.fen() << std::endl;
+  std::cout << "\t" << fen << std::endl;
   std::cout << "and depth = " << depth << std::endl;
 
-  std::map<std::string, size_t> expected =
-      get_stockfish_perft(board.fen(), depth);
-  std::vector<move_t> legal_moves = board.legal_moves();
-
-  if (depth <= 1 || legal_moves.size() != expected.size()) {
-    std::cout << "Found " << board.legal_moves().size()
-              << " legal moves:" << std::endl;
-    print_simple_move_list(board.legal_moves());
-
-    std::cout << "Stockfish found " << expected.size()
-              << " legal moves:" << std::endl;
-    for (const auto &[move, expected_perft] : expected) {
-      std::cout << move << ", ";
+  size_t total = 0;
+  std::map<std::string, std::pair<move_t, size_t>> actual;
+  for (const auto &[move, count] : perft_divide(board, depth, table)) {
+    actual[simple_string_from_move(move)] = {move, count};
+    total += count;
+  }
+  for (const auto &[move_name, entry] : actual)
+    std::cout << move_name << ": " << entry.second << std::endl;
+  std::cout << "Total: " << total << std::endl;
+
+  const auto it = divides.find({fen, depth});
+  if (it == divides.end()) {
+    std::cout << "No expected divide for this position at depth " << depth
+              << ", so the counts above are unchecked";
+    const char *separator = "; expected divides exist at depth ";
+    for (const auto &[key, moves] : divides) {
+      if (key.first != fen)
+        continue;
+      std::cout << separator << key.second;
+      separator = ", ";
     }
     std::cout << std::endl;
     return;
   }
+  const std::map<std::string, size_t> &expected = it->second;
 
-  for (const move_t move : legal_moves) {
-    if (board.make_move(move)) {
-      const size_t div_result = do_perft(board, depth - 1);
-      const std::string move_name = simple_string_from_move(move);
-      if (div_result != expected[move_name]) {
-        std::cout << "Perft divide result after making the move " << move_name
-                  << " differed:" << std::endl;
-        std::cout << "Board FEN: " << board.fen() << std::endl;
-        std::cout << "Expected: " << expected[move_name] << std::endl;
-        std::cout << "Got     : " << div_result << std::endl;
-        std::cout << "----------------------------" << std::endl;
-        do_perft_div(board, depth - 1);
-        return;
-      }
+  bool moves_differ = false;
+  for (const auto &[move_name, entry] : actual) {
+    if (!expected.contains(move_name)) {
+      std::cout << "Generated unexpected move " << move_name << std::endl;
+      moves_differ = true;
+    }
+  }
+  for (const auto &[move_name, count] : expected) {
+    if (!actual.contains(move_name)) {
+      std::cout << "Did not generate move " << move_name << std::endl;
+      moves_differ = true;
     }
-    board.unmake_move();
+  }
+  if (moves_differ)
+    return;
+
+  for (const auto &[move_name, entry] : actual) {
+    const auto &[move, count] = entry;
+    if (count == expected.at(move_name))
+      continue;
+    Board child(board);
+    child.make_move(move);
+    std::cout << "Perft divide result after making the move " << move_name
+              << " differed:" << std::endl;
+    std::cout << "Board FEN: " << child.fen() << std::endl;
+    std::cout << "Expected: " << expected.at(move_name) << std::endl;
+    std::cout << "Got     : " << count << std::endl;
+    std::cout << "----------------------------" << std::endl;
+    if (depth > 1)
+      do_perft_div(child, depth - 1, totals, divides, table);
+    return;
   }
 }
 
-bool test_perft(const std::string &file_name, int max_depth) {
+bool test_perft(const std::string &file_name, int max_depth,
+                const std::string &divide_file_name =
+                    "tests/perft_files/perft.divide") {
   const std::vector<perft_t> tests = load_perft(file_name);
+  // Positions recur across and within the perft files, so share one table
+  static PerftTable table;
   for (const auto &perft : tests) {
     Board board(perft.fen);
     const int depth = perft.depth;
@@ -142,13 +170,14 @@ bool test_perft(const std::string &file_name, int max_depth) {
     if (depth > max_depth)
       continue;
     const auto diff = timeit([&] {
-      const size_t actual_num = do_perft(board, depth);
+      const size_t actual_num = parallel_perft(board, depth, &table);
       if (actual_num != expect_num) {
         WASSERT_MSG(
             actual_num == expect_num,
             "Perft failed for %s with depth %d: expected %lu but got %lu",
             perft.fen.c_str(), depth, expect_num, actual_num);
-        do_perft_div(board, depth);
+        do_perft_div(board, depth, perft_totals(tests),
+                     load_perft_divides(divide_file_name), &table);
       }
     });
     std::cout << "Done perft " << perft.fen << " with depth " << depth
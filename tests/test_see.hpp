@@ -0,0 +1,46 @@
+#pragma once
+
+#include <string>
+
+#include "assert.hpp"
+#include "board.hpp"
+#include "move.hpp"
+#include "piece_values.hpp"
+#include "see.hpp"
+
+inline int test_see_move(const std::string &fen, const std::string &move_str,
+                         const int expected) {
+  const Board board(fen);
+  const move_t move = parse_move(board, move_str);
+  ASSERT_MSG(move != 0, "%s is not legal in %s", move_str.c_str(),
+             fen.c_str());
+  const int actual = see(board, move);
+  ASSERT_MSG(actual == expected, "SEE of %s in %s is %d, expected %d",
+             move_str.c_str(), fen.c_str(), actual, expected);
+  return 0;
+}
+
+inline int test_see() {
+  int fail_flag = 0;
+  // An undefended pawn
+  fail_flag |= test_see_move("1k1r4/1pp4p/p7/4p3/8/P5P1/1PP4P/2K1R3 w - - 0 1",
+                             "e1e5", PAWN_VALUE);
+  // A pawn defended by a pawn
+  fail_flag |=
+      test_see_move("4k3/8/3p4/4p3/8/8/8/4QK2 w - - 0 1", "e1e5",
+                    PAWN_VALUE - QUEEN_VALUE);
+  // An even trade
+  fail_flag |=
+      test_see_move("4k3/4r3/8/8/8/8/4R3/4K3 w - - 0 1", "e2e7", 0);
+  // The rook behind the capturer keeps the king from recapturing
+  fail_flag |=
+      test_see_move("4k3/4r3/8/8/8/8/4R3/4R1K1 w - - 0 1", "e2e7", ROOK_VALUE);
+  // Recapturing the knight would cost white the rook to the bishop
+  fail_flag |= test_see_move(
+      "1k1r3q/1ppn3p/p4b2/4p3/8/P2N2P1/1PP1R1BP/2K1Q3 w - - 0 1", "d3e5",
+      PAWN_VALUE - KNIGHT_VALUE);
+  // En-passant wins a pawn
+  fail_flag |= test_see_move("4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 1", "e5d6",
+                             PAWN_VALUE);
+  return fail_flag;
+}